@@ -0,0 +1,430 @@
+/***************************************************************************************************/
+/*
+   Cooperative i2c bus scheduler for LiquidCrystal_I2C library.
+
+   Shares one i2c bus between several displays & other i2c devices (sensors, eeproms & etc.).
+   Long transfers are split into chunks of I2C_SCHEDULER_CHUNK bytes & chunks of clients are
+   interleaved by priority, so display refresh never blocks the bus for longer than one chunk.
+
+   written by : enjoyneering79, edited by Jojo-A
+   sourse code: https://github.com/enjoyneering/
+
+   GNU GPL license, all text above must be included in any redistribution,
+   see link for details  - https://www.gnu.org/licenses/licenses.html
+*/
+/***************************************************************************************************/
+
+#include <string.h>
+
+#include "I2C_Scheduler.h"
+
+/* scheduler shares clients with i2c interrupts */
+#if defined(LCD_HOST_STUB)
+#define I2C_ENTER_CRITICAL() uint32_t primask = 0
+#define I2C_EXIT_CRITICAL()  (void)primask
+#else
+#define I2C_ENTER_CRITICAL() uint32_t primask = __get_PRIMASK(); __disable_irq()
+#define I2C_EXIT_CRITICAL()  __set_PRIMASK(primask)
+#endif
+
+const lcd_bus I2CschedulerLCDbus = {I2CschedulerLCDwrite, I2CschedulerLCDread, I2CschedulerLCDwriteAsync, LCDdelayMicroseconds, LCDtimestamp, LCDtimeElapsed, LCDuptime}; //display behind scheduler, handle is i2c_client
+
+
+/**************************************************************************/
+/*
+    I2CschedulerInit()
+
+    Initializes scheduler of one i2c bus
+
+    NOTE:
+    - bus is the real bus backend, e.g. LCDbusHAL & hi2c1
+    - call I2CschedulerTxComplete() from HAL_I2C_MasterTxCpltCallback()
+      & I2CschedulerError() from HAL_I2C_ErrorCallback() instead of
+      LCDasyncTxComplete() & LCDasyncError()
+*/
+/**************************************************************************/
+void I2CschedulerInit(i2c_scheduler *scheduler, const lcd_bus *bus, void *handle)
+{
+  memset(scheduler, 0, sizeof(i2c_scheduler));
+
+  scheduler->bus         = bus;
+  scheduler->handle      = handle;
+  scheduler->windowStart = bus->timestamp();
+}
+
+/**************************************************************************/
+/*
+    I2CschedulerAddClient()
+
+    Adds device to the bus
+
+    NOTE:
+    - priority 0 is the highest, e.g. 0 for sensors with sampling
+      deadlines & 3 for displays
+    - display client: callback = I2CschedulerLCDcallback, context = lcd,
+      then LCDinitBus(lcd, &I2CschedulerLCDbus, client, addr)
+    - returns false if there is no free client place
+*/
+/**************************************************************************/
+bool I2CschedulerAddClient(i2c_scheduler *scheduler, i2c_client *client, uint8_t priority, void (*callback)(i2c_client *client, lcd_bus_status status), void *context)
+{
+  if (scheduler->count >= I2C_SCHEDULER_CLIENTS) return false;
+
+  memset(client, 0, sizeof(i2c_client));
+
+  client->scheduler = scheduler;
+  client->priority  = priority;
+  client->callback  = callback;
+  client->context   = context;
+
+  scheduler->clients[scheduler->count++] = client;
+
+  return true;
+}
+
+/**************************************************************************/
+/*
+    I2CschedulerWrite()
+
+    Queues write request of the client
+
+    NOTE:
+    - request is sent by I2CschedulerService() in chunks, data must stay
+      valid until client callback
+    - returns LCD_BUS_BUSY if previous request of the client is not
+      done yet
+*/
+/**************************************************************************/
+lcd_bus_status I2CschedulerWrite(i2c_client *client, uint8_t address, const uint8_t *data, uint16_t length)
+{
+  return I2CschedulerSubmit(client, I2C_REQUEST_WRITE, address, (uint8_t *)data, length);
+}
+
+/**************************************************************************/
+/*
+    I2CschedulerRead()
+
+    Queues read request of the client
+
+    NOTE:
+    - read is never split, i2c read can't be continued in the next
+      transaction
+*/
+/**************************************************************************/
+lcd_bus_status I2CschedulerRead(i2c_client *client, uint8_t address, uint8_t *data, uint16_t length)
+{
+  return I2CschedulerSubmit(client, I2C_REQUEST_READ, address, data, length);
+}
+
+/**************************************************************************/
+/*
+    I2CschedulerSubmit()
+
+    Stores request in the client & starts it if bus is idle
+*/
+/**************************************************************************/
+lcd_bus_status I2CschedulerSubmit(i2c_client *client, i2c_request_type type, uint8_t address, uint8_t *data, uint16_t length)
+{
+  if (client->pending == true) return LCD_BUS_BUSY;
+
+  client->type    = type;
+  client->address = address;
+  client->data    = data;
+  client->length  = length;
+  client->status  = LCD_BUS_OK;
+  client->pending = true;
+
+  I2CschedulerService(client->scheduler);
+
+  return LCD_BUS_OK;
+}
+
+/**************************************************************************/
+/*
+    I2CschedulerService()
+
+    Starts the next chunk if bus is idle
+
+    NOTE:
+    - call it from main loop or periodic timer, it is also called on
+      every chunk complete
+    - the highest priority client with pending request gets the bus,
+      clients of the same priority take turns
+    - blocking bus backend (writeAsync = NULL) sends one chunk per call
+    - client is counted as served only if its chunk started, client
+      refused with LCD_BUS_BUSY is first again on the next call
+*/
+/**************************************************************************/
+void I2CschedulerService(i2c_scheduler *scheduler)
+{
+  i2c_client     *client   = NULL;
+  uint16_t        chunk    = 0;
+  uint8_t         index    = 0;
+  uint8_t         previous = scheduler->lastServed;
+  lcd_bus_status  status   = LCD_BUS_OK;
+
+  I2C_ENTER_CRITICAL();
+
+  if (scheduler->active != NULL)
+  {
+    I2C_EXIT_CRITICAL();
+    return;                                                        //chunk in progress
+  }
+
+  client = I2CschedulerNext(scheduler, &index);
+
+  if (client == NULL)
+  {
+    I2C_EXIT_CRITICAL();
+    return;                                                        //nothing to send
+  }
+
+  chunk = client->length;
+
+  if ((client->type == I2C_REQUEST_WRITE) && (chunk > I2C_SCHEDULER_CHUNK)) chunk = I2C_SCHEDULER_CHUNK;
+
+  scheduler->active     = client;
+  scheduler->chunk      = chunk;
+  scheduler->lastServed = index;                                   //set before start, chunk may complete in interrupt before bus call returns
+
+  I2C_EXIT_CRITICAL();
+
+  scheduler->busyStart = scheduler->bus->timestamp();
+
+  if ((client->type == I2C_REQUEST_WRITE) && (scheduler->bus->writeAsync != NULL))
+  {
+    status = scheduler->bus->writeAsync(scheduler->handle, client->address, client->data, chunk);
+
+    if (status == LCD_BUS_OK) return;                              //I2CschedulerTxComplete() continues
+  }
+  else if (client->type == I2C_REQUEST_WRITE)
+  {
+    status = scheduler->bus->write(scheduler->handle, client->address, client->data, chunk);
+  }
+  else
+  {
+    status = scheduler->bus->read(scheduler->handle, client->address, client->data, chunk);
+  }
+
+  if (status == LCD_BUS_BUSY)
+  {
+    scheduler->active     = NULL;                                  //bus is used outside of scheduler, try later
+    scheduler->lastServed = previous;                              //chunk didn't start, client keeps its turn
+    return;
+  }
+
+  I2CschedulerFinish(scheduler, status);                           //blocking transfer is already done
+}
+
+/**************************************************************************/
+/*
+    I2CschedulerNext()
+
+    Returns pending client with the highest priority, NULL if there is
+    nothing to send
+
+    NOTE:
+    - search starts after the last served client, so clients of the same
+      priority take turns
+    - bestIndex is place of returned client, lastServed is not changed
+      here, see I2CschedulerService()
+*/
+/**************************************************************************/
+i2c_client *I2CschedulerNext(i2c_scheduler *scheduler, uint8_t *bestIndex)
+{
+  i2c_client *best  = NULL;
+  uint8_t     index = 0;
+
+  for (uint8_t i = 1; i <= scheduler->count; i++)
+  {
+    index = (scheduler->lastServed + i) % scheduler->count;
+
+    if (scheduler->clients[index]->pending == false) continue;
+
+    if ((best == NULL) || (scheduler->clients[index]->priority < best->priority))
+    {
+      best       = scheduler->clients[index];
+      *bestIndex = index;
+    }
+  }
+
+  return best;
+}
+
+/**************************************************************************/
+/*
+    I2CschedulerTxComplete()
+
+    Ends current chunk & starts the next one, call it from
+    HAL_I2C_MasterTxCpltCallback()
+
+    NOTE:
+    - transfers of other i2c handles are ignored
+*/
+/**************************************************************************/
+void I2CschedulerTxComplete(i2c_scheduler *scheduler, void *handle)
+{
+  if ((handle != scheduler->handle) || (scheduler->active == NULL)) return;
+
+  I2CschedulerFinish(scheduler, LCD_BUS_OK);
+  I2CschedulerService(scheduler);
+}
+
+/**************************************************************************/
+/*
+    I2CschedulerError()
+
+    Ends request of current client with error, call it from
+    HAL_I2C_ErrorCallback()
+*/
+/**************************************************************************/
+void I2CschedulerError(i2c_scheduler *scheduler, void *handle)
+{
+  if ((handle != scheduler->handle) || (scheduler->active == NULL)) return;
+
+  I2CschedulerFinish(scheduler, LCD_BUS_ERROR);
+  I2CschedulerService(scheduler);
+}
+
+/**************************************************************************/
+/*
+    I2CschedulerFinish()
+
+    Counts finished chunk & calls client callback when request is done
+*/
+/**************************************************************************/
+void I2CschedulerFinish(i2c_scheduler *scheduler, lcd_bus_status status)
+{
+  i2c_client *client = scheduler->active;
+
+  scheduler->busyTime += scheduler->bus->timestamp() - scheduler->busyStart;
+
+  client->transactions++;
+
+  if (status == LCD_BUS_OK)
+  {
+    client->bytes  += scheduler->chunk;
+    client->data   += scheduler->chunk;
+    client->length -= scheduler->chunk;
+  }
+  else
+  {
+    client->length = 0;                                            //request is dropped
+  }
+
+  scheduler->active = NULL;
+
+  if (client->length != 0) return;                                 //next chunk, see I2CschedulerService()
+
+  client->status  = status;
+  client->pending = false;
+
+  if (client->callback != NULL) client->callback(client, status);
+}
+
+/**************************************************************************/
+/*
+    I2CschedulerUtilization()
+
+    Returns bus utilization since the last call, in 0.1%
+
+    NOTE:
+    - e.g. 250 = bus was busy 25% of time
+    - time is measured by bus timestamp, call it more often than the
+      timestamp overflows, e.g. ~59sec for DWT @ 72MHz
+*/
+/**************************************************************************/
+uint16_t I2CschedulerUtilization(i2c_scheduler *scheduler)
+{
+  uint32_t now         = scheduler->bus->timestamp();
+  uint32_t window      = now - scheduler->windowStart;
+  uint16_t utilization = 0;
+
+  if (window != 0) utilization = ((uint64_t)scheduler->busyTime * 1000) / window;
+
+  if (utilization > 1000) utilization = 1000;                      //chunk started before window & ended in it
+
+  scheduler->busyTime    = 0;
+  scheduler->windowStart = now;
+
+  return utilization;
+}
+
+/**************************************************************************/
+/*
+    I2CschedulerLCDcallback()
+
+    Client callback of display, moves display async queue forward
+*/
+/**************************************************************************/
+void I2CschedulerLCDcallback(i2c_client *client, lcd_bus_status status)
+{
+  LiquidCrystal_I2C *lcd = (LiquidCrystal_I2C *)client->context;
+
+  if (status == LCD_BUS_OK) LCDasyncTxComplete(lcd, client);
+  else                      LCDasyncError(lcd, client);
+}
+
+/**************************************************************************/
+/*
+    I2CschedulerWait()
+
+    Services the bus until request of the client is done
+
+    NOTE:
+    - chunks of higher priority clients are sent in between
+*/
+/**************************************************************************/
+lcd_bus_status I2CschedulerWait(i2c_client *client)
+{
+  while (client->pending == true) I2CschedulerService(client->scheduler);
+
+  return client->status;
+}
+
+/**************************************************************************/
+/*
+    I2CschedulerLCDwrite()
+
+    Blocking write of display behind scheduler, see I2CschedulerLCDbus
+*/
+/**************************************************************************/
+lcd_bus_status I2CschedulerLCDwrite(void *handle, uint8_t address, const uint8_t *data, uint16_t length)
+{
+  i2c_client *client = (i2c_client *)handle;
+
+  if (I2CschedulerWrite(client, address, data, length) != LCD_BUS_OK) return LCD_BUS_BUSY;
+
+  return I2CschedulerWait(client);
+}
+
+/**************************************************************************/
+/*
+    I2CschedulerLCDread()
+
+    Blocking read of display behind scheduler, see I2CschedulerLCDbus
+*/
+/**************************************************************************/
+lcd_bus_status I2CschedulerLCDread(void *handle, uint8_t address, uint8_t *data, uint16_t length)
+{
+  i2c_client *client = (i2c_client *)handle;
+
+  if (I2CschedulerRead(client, address, data, length) != LCD_BUS_OK) return LCD_BUS_BUSY;
+
+  return I2CschedulerWait(client);
+}
+
+/**************************************************************************/
+/*
+    I2CschedulerLCDwriteAsync()
+
+    Async write of display behind scheduler, see I2CschedulerLCDbus
+
+    NOTE:
+    - request is done in I2CschedulerLCDcallback()
+*/
+/**************************************************************************/
+lcd_bus_status I2CschedulerLCDwriteAsync(void *handle, uint8_t address, const uint8_t *data, uint16_t length)
+{
+  return I2CschedulerWrite((i2c_client *)handle, address, data, length);
+}
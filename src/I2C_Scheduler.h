@@ -0,0 +1,98 @@
+/***************************************************************************************************/
+/*
+   Cooperative i2c bus scheduler for LiquidCrystal_I2C library.
+
+   Shares one i2c bus between several displays & other i2c devices (sensors, eeproms & etc.).
+   Long transfers are split into chunks of I2C_SCHEDULER_CHUNK bytes & chunks of clients are
+   interleaved by priority, so display refresh never blocks the bus for longer than one chunk.
+
+   written by : enjoyneering79, edited by Jojo-A
+   sourse code: https://github.com/enjoyneering/
+
+   GNU GPL license, all text above must be included in any redistribution,
+   see link for details  - https://www.gnu.org/licenses/licenses.html
+*/
+/***************************************************************************************************/
+
+#ifndef I2C_Scheduler_h
+#define I2C_Scheduler_h
+
+#include "LiquidCrystal_I2C.h"
+
+/* scheduler misc. */
+#define I2C_SCHEDULER_CLIENTS    8     //max. clients on one bus
+#define I2C_SCHEDULER_CHUNK      32    //max. bytes written in one bus transaction, sets worst case wait of other clients
+
+typedef enum : uint8_t
+{
+  I2C_REQUEST_WRITE            = 0x00,
+  I2C_REQUEST_READ             = 0x01  //never split, see I2CschedulerRead()
+}
+i2c_request_type;
+
+struct i2c_scheduler;
+
+/* bus client, one per device */
+typedef struct i2c_client
+{
+  struct i2c_scheduler *scheduler;
+  uint8_t               priority;      //0 - highest
+  void                (*callback)(struct i2c_client *client, lcd_bus_status status); //called when request is done, may be NULL
+  void                 *context;       //user data, e.g. LiquidCrystal_I2C
+
+  /* request */
+  i2c_request_type      type;
+  uint8_t               address;       //7-bit
+  uint8_t              *data;
+  uint16_t              length;        //bytes left
+  volatile bool         pending;
+  volatile lcd_bus_status status;      //status of the last request
+
+  /* statistics */
+  uint32_t              bytes;
+  uint32_t              transactions;
+}
+i2c_client;
+
+/* scheduler, one per bus */
+typedef struct i2c_scheduler
+{
+  const lcd_bus        *bus;           //bus backend, e.g. LCDbusHAL
+  void                 *handle;        //e.g. I2C_HandleTypeDef
+  i2c_client           *clients[I2C_SCHEDULER_CLIENTS];
+  uint8_t               count;
+  uint8_t               lastServed;    //round robin between clients of the same priority
+  i2c_client * volatile active;        //client of the current chunk
+  volatile uint16_t     chunk;
+
+  /* utilization */
+  uint32_t              busyStart;
+  uint32_t              busyTime;      //bus timestamp units
+  uint32_t              windowStart;
+}
+i2c_scheduler;
+
+extern const lcd_bus I2CschedulerLCDbus;
+
+void           I2CschedulerInit(i2c_scheduler *scheduler, const lcd_bus *bus, void *handle);
+bool           I2CschedulerAddClient(i2c_scheduler *scheduler, i2c_client *client, uint8_t priority, void (*callback)(i2c_client *client, lcd_bus_status status), void *context);
+lcd_bus_status I2CschedulerWrite(i2c_client *client, uint8_t address, const uint8_t *data, uint16_t length);
+lcd_bus_status I2CschedulerRead(i2c_client *client, uint8_t address, uint8_t *data, uint16_t length);
+void           I2CschedulerService(i2c_scheduler *scheduler);
+void           I2CschedulerTxComplete(i2c_scheduler *scheduler, void *handle);
+void           I2CschedulerError(i2c_scheduler *scheduler, void *handle);
+uint16_t       I2CschedulerUtilization(i2c_scheduler *scheduler);
+void           I2CschedulerLCDcallback(i2c_client *client, lcd_bus_status status);
+
+/**************************************************************************/
+
+i2c_client    *I2CschedulerNext(i2c_scheduler *scheduler, uint8_t *bestIndex);
+void           I2CschedulerFinish(i2c_scheduler *scheduler, lcd_bus_status status);
+lcd_bus_status I2CschedulerSubmit(i2c_client *client, i2c_request_type type, uint8_t address, uint8_t *data, uint16_t length);
+lcd_bus_status I2CschedulerWait(i2c_client *client);
+lcd_bus_status I2CschedulerLCDwrite(void *handle, uint8_t address, const uint8_t *data, uint16_t length);
+lcd_bus_status I2CschedulerLCDread(void *handle, uint8_t address, uint8_t *data, uint16_t length);
+lcd_bus_status I2CschedulerLCDwriteAsync(void *handle, uint8_t address, const uint8_t *data, uint16_t length);
+/**************************************************************************/
+
+#endif
@@ -19,54 +19,103 @@
 */
 /***************************************************************************************************/
 
+#include <string.h>
+
 #include "LiquidCrystal_I2C.h"
 
+#if defined(LCD_HOST_STUB)
+#include <time.h>                                            //nanosleep(), clock_gettime()
+#endif
+
+#if defined(LCD_DELAY_TIMER)
+extern TIM_HandleTypeDef LCD_DELAY_TIMER;
+#endif
+
+/* arduino bit macros, STM32 HAL has no equivalent */
+#ifndef bitRead
+#define bitRead(value, bit)            (((value) >> (bit)) & 0x01)
+#define bitSet(value, bit)             ((value) |= (1UL << (bit)))
+#define bitClear(value, bit)           ((value) &= ~(1UL << (bit)))
+#define bitWrite(value, bit, bitvalue) ((bitvalue) ? bitSet(value, bit) : bitClear(value, bit))
+#endif
+
+/* async engine shares queue with i2c interrupts */
+#if defined(LCD_HOST_STUB)
+#define LCD_ENTER_CRITICAL() uint32_t primask = 0
+#define LCD_EXIT_CRITICAL()  (void)primask
+#else
+#define LCD_ENTER_CRITICAL() uint32_t primask = __get_PRIMASK(); __disable_irq()
+#define LCD_EXIT_CRITICAL()  __set_PRIMASK(primask)
+#endif
+
+const uint8_t LCDpinMapping[8] = {4, 5, 6, 16, 11, 12, 13, 14}; //default backpack, see README.md
+
+#if !defined(LCD_HOST_STUB)
+const lcd_bus LCDbusHAL = {LCDhalWrite, LCDhalRead, LCDhalWriteAsync, LCDdelayMicroseconds, LCDtimestamp, LCDtimeElapsed, LCDuptime}; //STM32 HAL i2c & delay backend
+#endif
 
-/**************************************************************************/
 /*
-    LiquidCrystal_I2C()
-
-    Constructor. Initializes the class variables, defines I2C address,
-    LCD & PCF8574 pins.
+   interface chips
+   NOTE: PCF8574 & MCP230xx bytes are paced by E toggle, 2 bytes per command cover 37us @ 400kHz,
+         ST7032 & AiP31068 data write takes 26.3us & 43us, longer than 22.5us of one byte @ 400kHz,
+         so data is sent in Co=1 pairs, 2 bytes per character, data stream with 1 byte per character
+         is used if LCD_I2C_CLOCK is slow enough, e.g. 100kHz, see LCDencodeNative()
 */
-/**************************************************************************/
+const lcd_backend LCDbackendPCF8574  = {LCDencode,         LCDportPCF8574,  NULL,             NULL,               0,                         0,              0, LCD_4BIT_MODE, true,  true,  false, 0};  //default backpack, 4 bytes per character
+const lcd_backend LCDbackendMCP23008 = {LCDencode,         LCDportPCF8574,  LCDsetupMCP23008, NULL,               0,                         MCP23008_GPIO,  1, LCD_4BIT_MODE, true,  false, true,  0};  //same wiring as PCF8574, e.g. Adafruit i2c backpack
+const lcd_backend LCDbackendMCP23017 = {LCDencodeMCP23017, LCDportMCP23017, LCDsetupMCP23017, NULL,               0,                         MCP23017_GPIOB, 1, LCD_8BIT_MODE, true,  false, true,  0};  //8-bit interface, 4 bytes per character
+const lcd_backend LCDbackendST7032   = {LCDencodeNative,   LCDportNative,   NULL,             LCDextensionST7032, LCD_ST7032_FOLLOWER_DELAY, 0,              0, LCD_8BIT_MODE, false, false, true,  27}; //2 bytes per character @ 400kHz, 1 byte in data stream @ 100kHz
+const lcd_backend LCDbackendAiP31068 = {LCDencodeNative,   LCDportNative,   NULL,             NULL,               0,                         0,              0, LCD_8BIT_MODE, false, false, true,  43}; //same as ST7032 without contrast & power circuits
 
-const uint8_t LCDpinMapping[8] = {4, 5, 6, 16, 11, 12, 13, 14}
-
-LiquidCrystal_I2C _lcd;
 
 /**************************************************************************/
 /*
-    LCDbegin()
+    LCDinit()
 
-    Initializes, resets & configures I2C bus & LCD
+    Constructor. Initializes the context variables, defines I2C bus,
+    I2C address, LCD & PCF8574 pins.
+
+    NOTE:
+    - every display has own context, so several displays can be
+      driven on one or more i2c buses
+    - pinMapping = NULL selects default {4,5,6,16,11,12,13,14} backpack
+    - STM32 HAL bus, see LCDinitBus() for other buses
 */
 /**************************************************************************/
-bool LCDbegin(LiquidCrystal_I2C lcd);
+#if !defined(LCD_HOST_STUB)
+void LCDinit(LiquidCrystal_I2C *lcd, I2C_HandleTypeDef *hi2c, PCF8574_address addr, const uint8_t *pinMapping, backlightPolarity polarity)
 {
-  LCDinit(lcd);
-	
-  if (_PCF8574_initialisation == false) return false; //safety check, make sure the declaration of lcd pins is right
+  LCDinitBus(lcd, &LCDbusHAL, hi2c, addr, pinMapping, polarity);
+}
+#endif
 
-  //Wire.beginTransmission(_PCF8574_address);
-  //if (Wire.endTransmission() != 0) return false;      //safety check, make sure the PCF8574 is connected
+/**************************************************************************/
+/*
+    LCDinitBus()
 
-  if(writePCF8574(PCF8574_ALL_LOW) == false) return false;                      //safety check, set all PCF8574 pins low
-	
-  _lcd.colums 	 = lcd.colums;
-  _lcd.rows      = lcd.rows;
-  _lcd.font_size = lcd.f_size;
+    Constructor. Same as LCDinit(), but i2c transactions & delays are
+    done by user bus backend
 
-  LCDinitialization();                                   //soft reset & 4-bit mode initialization
+    NOTE:
+    - handle is passed to every bus call & identifies the bus in
+      LCDasyncTxComplete() & LCDasyncError()
+    - bus->writeAsync = NULL, async queue is sent by blocking writes
+*/
+/**************************************************************************/
+void LCDinitBus(LiquidCrystal_I2C *lcd, const lcd_bus *bus, void *handle, PCF8574_address addr, const uint8_t *pinMapping, backlightPolarity polarity)
+{
+  memset(lcd, 0, sizeof(LiquidCrystal_I2C));                   //DO NOT CHANGE!!! default state of all controls is zero
 
-  return true;
-}
+  if (pinMapping == NULL) pinMapping = LCDpinMapping;
 
-LCDinit(PCF8574_address addr, uint8_t* pinMapping, backlightPolarity polarity)
-{
-  _PCF8574_address        = addr;
-  _PCF8574_initialisation = true;
-  _backlightPolarity      = polarity;
+  lcd->_bus                    = bus;
+  lcd->_busHandle              = handle;
+  lcd->_PCF8574_address        = addr;
+  lcd->_PCF8574_initialisation = true;
+  lcd->_backlightPolarity      = polarity;
+  lcd->_refreshPeriod          = LCD_REFRESH_PERIOD;
+  lcd->_refreshBudget          = LCD_REFRESH_BUDGET;
+  lcd->_addressCounter         = LCD_ADDRESS_UNKNOWN;
 
   /* maping LCD pins to PCF8574 ports */
   for (uint8_t i = 0; i < 8; i++)
@@ -74,57 +123,193 @@ LCDinit(PCF8574_address addr, uint8_t* pinMapping, backlightPolarity polarity)
     switch(*pinMapping)
     {
       case 4:                   //RS pin
-        _LCD_TO_PCF8574[7] = i;
+        lcd->_LCD_TO_PCF8574[7] = i;
         break;
 
       case 5:                   //RW pin
-        _LCD_TO_PCF8574[6] = i;
+        lcd->_LCD_TO_PCF8574[6] = i;
         break;
 
       case 6:                   //EN pin
-        _LCD_TO_PCF8574[5] = i;
+        lcd->_LCD_TO_PCF8574[5] = i;
         break;
 
       case 14:                  //D7 pin
-        _LCD_TO_PCF8574[4] = i;
+        lcd->_LCD_TO_PCF8574[4] = i;
         break;
 
       case 13:                  //D6 pin
-        _LCD_TO_PCF8574[3] = i;
+        lcd->_LCD_TO_PCF8574[3] = i;
         break;
 
       case 12:                  //D5 pin
-        _LCD_TO_PCF8574[2] = i;
+        lcd->_LCD_TO_PCF8574[2] = i;
         break;
 
       case 11:                  //D4 pin
-        _LCD_TO_PCF8574[1] = i;
+        lcd->_LCD_TO_PCF8574[1] = i;
         break;
 
       case 16:                  //BL pin
-        _LCD_TO_PCF8574[0] = i;
+        lcd->_LCD_TO_PCF8574[0] = i;
         break;
 
       default:
-        _PCF8574_initialisation = false; //safety check, make sure the declaration of lcd pins is right
+        lcd->_PCF8574_initialisation = false; //safety check, make sure the declaration of lcd pins is right
         break;
-      pinMapping++;
     }
+
+    pinMapping++;
   }
 
+  #if defined(LCD_STANDARD_BACKPACK)
+  const uint8_t standardMapping[8] = {3, 4, 5, 6, 7, 2, 1, 0}; //{BCK_LED,DB4,DB5,DB6,DB7,E,RW,RS} ports of {4,5,6,16,11,12,13,14} backpack
+
+  if (memcmp(lcd->_LCD_TO_PCF8574, standardMapping, 8) != 0) lcd->_PCF8574_initialisation = false; //safety check, constant mapping is valid for standard backpack only
+  #endif
+
+  LCDportMappingInit(lcd);
+  LCDbackend(lcd, &LCDbackendPCF8574);
+
   /* backlight control via PCF8574 */
-  switch (_backlightPolarity)
-  {
-    case POSITIVE:
-      _backlightValue = LCD_BACKLIGHT_ON;
-      break;
+  lcd->_backlightValue = LCDbacklightValue(lcd, true);
+}
 
-    case NEGATIVE:
-      _backlightValue = ~LCD_BACKLIGHT_ON;
-      break;
+/**************************************************************************/
+/*
+    LCDbackend()
+
+    Selects lcd interface chip, call it after LCDinit() & before
+    LCDbegin()
+
+    NOTE:
+    - LCDbackendPCF8574 is used by default, 4-bit interface, 4 bytes per
+      character
+    - LCDbackendMCP23008 is wired same as PCF8574 & adds register byte to
+      every transaction
+    - LCDbackendMCP23017 drives 8-bit interface, DB0..DB7 on port B,
+      RS,RW,E & BCK_LED on port A same as PCF8574, E still toggles, so
+      character takes 4 bytes too
+    - LCDbackendST7032 & LCDbackendAiP31068 are native i2c controllers,
+      use LCD_NATIVE_ADDR, character takes 2 bytes @ 400kHz & 1 byte
+      in data stream @ 100kHz, see LCD_I2C_CLOCK
+    - busy flag polling & async engine are supported by PCF8574 only
+*/
+/**************************************************************************/
+void LCDbackend(LiquidCrystal_I2C *lcd, const lcd_backend *backend)
+{
+  lcd->_backend     = backend;
+  lcd->_txBuffer[0] = backend->prefix;                  //prefix is never overwritten, see LCDflushTxBuffer()
+  lcd->_txStart     = backend->prefixLength;
+  lcd->_txLength    = backend->prefixLength;
+  lcd->_txStream    = false;
+
+  if (backend->readable == false) lcd->_busyFlagPolling = false;
+}
+
+/**************************************************************************/
+/*
+    LCDbegin()
+
+    Initializes, resets & configures I2C bus & LCD
+
+    NOTE:
+    - call LCDinit() first
+    - returns false if display is not connected, it is brought up later
+      by LCDlinkService()
+*/
+/**************************************************************************/
+bool LCDbegin(LiquidCrystal_I2C *lcd, uint8_t lcd_colums, uint8_t lcd_rows, lcd_font_size f_size)
+{
+  bool connected = LCDbeginPCF8574(lcd, lcd_colums, lcd_rows, f_size);
+
+  if (lcd->_PCF8574_initialisation == false) return false;
+
+  LCDinitialization(lcd);                                //soft reset & 4-bit mode initialization, only tracked if not connected, see LCDlinkService()
+
+  return connected;
+}
+
+/**************************************************************************/
+/*
+    LCDbeginWarm()
+
+    Same as LCDbegin(), but reprograms lcd modes without power-on wait
+    & soft reset
+
+    NOTE:
+    - for MCU restart without lcd power loss, lcd has to be in 4-bit
+      mode already, e.g. after watchdog reset or firmware update
+    - if MCU reset could interrupt i2c transfer, lcd may be waiting for
+      the second nibble of a command, use LCDbegin() to resync it
+    - takes ~2ms instead of ~52ms
+*/
+/**************************************************************************/
+bool LCDbeginWarm(LiquidCrystal_I2C *lcd, uint8_t lcd_colums, uint8_t lcd_rows, lcd_font_size f_size)
+{
+  bool connected = LCDbeginPCF8574(lcd, lcd_colums, lcd_rows, f_size);
+
+  if (lcd->_PCF8574_initialisation == false) return false;
+
+  LCDbeginBatch(lcd);
+  LCDconfiguration(lcd);
+  LCDendBatch(lcd);
+
+  return connected;
+}
+
+/**************************************************************************/
+/*
+    LCDbeginPCF8574()
+
+    Checks PCF8574 & stores lcd geometry, common part of LCDbegin() &
+    LCDbeginWarm()
+*/
+/**************************************************************************/
+bool LCDbeginPCF8574(LiquidCrystal_I2C *lcd, uint8_t lcd_colums, uint8_t lcd_rows, lcd_font_size f_size)
+{
+  LCDdelayInit();
+	
+  if (lcd->_PCF8574_initialisation == false) return false; //safety check, make sure the declaration of lcd pins is right
+
+  lcd->_lcd_colums    = lcd_colums;                    //LCDlinkService() needs geometry if display is connected later
+  lcd->_lcd_rows      = lcd_rows;
+  lcd->_lcd_font_size = f_size;
+
+  return LCDprobe(lcd);                                 //safety check, make sure the PCF8574 is connected & set all PCF8574 pins low
+}
+
+/**************************************************************************/
+/*
+    LCDbeginPanels()
+
+    Same as LCDbegin(), but for several lcd with the same geometry at
+    once
+
+    NOTE:
+    - call LCDinit() for every panel first
+    - commands of the next panel are sent while previous panels execute
+      theirs, so N panels start in about the time of one
+    - panels without PCF8574 response are skipped, the rest is started
+    - returns false if any panel failed
+*/
+/**************************************************************************/
+bool LCDbeginPanels(LiquidCrystal_I2C *const *panels, uint8_t count, uint8_t lcd_colums, uint8_t lcd_rows, lcd_font_size f_size)
+{
+  uint16_t ready = 0;
+
+  if (count > LCD_MAX_PANELS) count = LCD_MAX_PANELS;           //safety check
+
+  for (uint8_t i = 0; i < count; i++)
+  {
+    if (LCDbeginPCF8574(panels[i], lcd_colums, lcd_rows, f_size) == true) bitSet(ready, i);
   }
 
-  _backlightValue <<= _LCD_TO_PCF8574[0];
+  if (ready == 0) return false;
+
+  LCDinitializationPanels(panels, count, ready);
+
+  return ready == (uint16_t)((1UL << count) - 1);
 }
 
 
@@ -140,11 +325,22 @@ LCDinit(PCF8574_address addr, uint8_t* pinMapping, backlightPolarity polarity)
     - command duration > 1.53 - 1.64ms
 */
 /**************************************************************************/
-void LCDclear(void)
+void LCDclear(LiquidCrystal_I2C *lcd)
 {
-  LCDsend(LCD_INSTRUCTION_WRITE, LCD_CLEAR_DISPLAY, LCD_CMD_LENGTH_8BIT);
+  LCDgraphReset(lcd);
+
+  if (lcd->_frameBufferMode == true)
+  {
+    memset(lcd->_frameBuffer, 0x20, sizeof(lcd->_frameBuffer));         //0x20 - built in "space" symbol
+    lcd->_frameCursor = 0;
+
+    return;
+  }
+
+  LCDsend(lcd, LCD_INSTRUCTION_WRITE, LCD_CLEAR_DISPLAY, LCD_CMD_LENGTH_8BIT); //clear resets display shift too, see LCDtrackState()
+  LCDflushTxBuffer(lcd);                                                  //in batch mode command still in the buffer
 
-  HAL_Delay(LCD_HOME_CLEAR_DELAY);
+  LCDwaitReady(lcd, LCD_HOME_CLEAR_DELAY * 1000);
 }
 
 /**************************************************************************/
@@ -159,11 +355,12 @@ void LCDclear(void)
     - command duration > 1.53 - 1.64ms
 */
 /**************************************************************************/
-void LCDhome(void)
+void LCDhome(LiquidCrystal_I2C *lcd)
 {
-  LCDsend(LCD_INSTRUCTION_WRITE, LCD_RETURN_HOME, LCD_CMD_LENGTH_8BIT);
+  LCDsend(lcd, LCD_INSTRUCTION_WRITE, LCD_RETURN_HOME, LCD_CMD_LENGTH_8BIT); //home resets display shift too, see LCDtrackState()
+  LCDflushTxBuffer(lcd);                                                  //in batch mode command still in the buffer
 
-  HAL_Delay(LCD_HOME_CLEAR_DELAY);
+  LCDwaitReady(lcd, LCD_HOME_CLEAR_DELAY * 1000);
 }
 
 /**************************************************************************/
@@ -176,17 +373,51 @@ void LCDhome(void)
     - cursor start position (0, 0)
     - cursor end   position (lcd_colums - 1, lcd_rows - 1)
     - DDRAM data/text is sent & received after this setting
+    - command is skipped if address counter is already at the position,
+      see LCDtrackState()
+    - unknown mode registers are sent first, see LCDtrackLost()
 */
 /**************************************************************************/
-void LCDsetCursor(uint8_t colum, uint8_t row)
+void LCDsetCursor(LiquidCrystal_I2C *lcd, uint8_t colum, uint8_t row)
 {
-  uint8_t row_address_offset[] = {0x00, 0x40, uint8_t(0x00 + _lcd_colums), uint8_t(0x40 + _lcd_colums)};
+  uint8_t address = 0;
 
   /* safety check, cursor position & array are zero indexed */
-  if (row   >= _lcd_rows)   row   = (_lcd_rows   - 1);
-  if (colum >= _lcd_colums) colum = (_lcd_colums - 1);
+  if (row   >= lcd->_lcd_rows)   row   = (lcd->_lcd_rows   - 1);
+  if (colum >= lcd->_lcd_colums) colum = (lcd->_lcd_colums - 1);
+
+  if (lcd->_frameBufferMode == true)
+  {
+    lcd->_frameCursor = (row * lcd->_lcd_colums) + colum;
+
+    return;
+  }
+
+  address = LCDrowAddress(lcd, row, colum);
+
+  if (address == lcd->_addressCounter) return;                            //lcd is already there
+
+  if (lcd->_displayModeSent == LCD_MODE_UNKNOWN) LCDupdateModes(lcd);     //registers are lost on busy bus, see LCDtrackLost()
+
+  LCDsend(lcd, LCD_INSTRUCTION_WRITE, LCD_DDRAM_ADDR_SET | address, LCD_CMD_LENGTH_8BIT);
+}
+
+/**************************************************************************/
+/*
+    LCDrowAddress()
+
+    Returns DDRAM address of the colum & row
+
+    NOTE:
+    - row 0 & row 1 start at 0x00 & 0x40, row 2 & row 3 are the
+      continuation of row 0 & row 1
+*/
+/**************************************************************************/
+uint8_t LCDrowAddress(LiquidCrystal_I2C *lcd, uint8_t row, uint8_t colum)
+{
+  uint8_t row_address_offset[] = {0x00, 0x40, uint8_t(0x00 + lcd->_lcd_colums), uint8_t(0x40 + lcd->_lcd_colums)};
 
-  LCDsend(LCD_INSTRUCTION_WRITE, LCD_DDRAM_ADDR_SET | (row_address_offset[row] + colum), LCD_CMD_LENGTH_8BIT);
+  return row_address_offset[row] + colum;
 }
 
 /**************************************************************************/
@@ -199,11 +430,11 @@ void LCDsetCursor(uint8_t colum, uint8_t row)
     - text remains in DDRAM
 */
 /**************************************************************************/
-void LCDnoDisplay(void)
+void LCDnoDisplay(LiquidCrystal_I2C *lcd)
 {
-  _displayControl &= ~LCD_DISPLAY_ON;
+  lcd->_displayControl &= ~LCD_DISPLAY_ON;
 
-  LCDsend(LCD_INSTRUCTION_WRITE, LCD_DISPLAY_CONTROL | _displayControl, LCD_CMD_LENGTH_8BIT);
+  LCDupdateModes(lcd);
 }
 
 /**************************************************************************/
@@ -216,11 +447,11 @@ void LCDnoDisplay(void)
     - text remains in DDRAM
 */
 /**************************************************************************/
-void LCDdisplay(void)
+void LCDdisplay(LiquidCrystal_I2C *lcd)
 {
-  _displayControl |= LCD_DISPLAY_ON;
+  lcd->_displayControl |= LCD_DISPLAY_ON;
 
-  LCDsend(LCD_INSTRUCTION_WRITE, LCD_DISPLAY_CONTROL | _displayControl, LCD_CMD_LENGTH_8BIT);
+  LCDupdateModes(lcd);
 }
 
 /**************************************************************************/
@@ -230,11 +461,11 @@ void LCDdisplay(void)
     Turns OFF the underline cursor
 */
 /**************************************************************************/
-void LCDnoCursor(void)
+void LCDnoCursor(LiquidCrystal_I2C *lcd)
 {
-  _displayControl &= ~LCD_UNDERLINE_CURSOR_ON;
+  lcd->_displayControl &= ~LCD_UNDERLINE_CURSOR_ON;
 
-  LCDsend(LCD_INSTRUCTION_WRITE, LCD_DISPLAY_CONTROL | _displayControl, LCD_CMD_LENGTH_8BIT);
+  LCDupdateModes(lcd);
 }
 
 /**************************************************************************/
@@ -244,11 +475,11 @@ void LCDnoCursor(void)
     Turns ON the underline cursor
 */
 /**************************************************************************/
-void LCDcursor(void)
+void LCDcursor(LiquidCrystal_I2C *lcd)
 {
-  _displayControl |= LCD_UNDERLINE_CURSOR_ON;
+  lcd->_displayControl |= LCD_UNDERLINE_CURSOR_ON;
 
-  LCDsend(LCD_INSTRUCTION_WRITE, LCD_DISPLAY_CONTROL | _displayControl, LCD_CMD_LENGTH_8BIT);
+  LCDupdateModes(lcd);
 }
 
 /**************************************************************************/
@@ -258,11 +489,11 @@ void LCDcursor(void)
     Turns OFF the blinking cursor
 */
 /**************************************************************************/
-void LCDnoBlink(void)
+void LCDnoBlink(LiquidCrystal_I2C *lcd)
 {
-  _displayControl &= ~LCD_BLINK_CURSOR_ON;
+  lcd->_displayControl &= ~LCD_BLINK_CURSOR_ON;
 
-  LCDsend(LCD_INSTRUCTION_WRITE, LCD_DISPLAY_CONTROL | _displayControl, LCD_CMD_LENGTH_8BIT);
+  LCDupdateModes(lcd);
 }
 
 /**************************************************************************/
@@ -272,11 +503,11 @@ void LCDnoBlink(void)
     Turns ON the blinking cursor
 */
 /**************************************************************************/
-void LCDblink(void)
+void LCDblink(LiquidCrystal_I2C *lcd)
 {
-  _displayControl |= LCD_BLINK_CURSOR_ON;
+  lcd->_displayControl |= LCD_BLINK_CURSOR_ON;
 
-  LCDsend(LCD_INSTRUCTION_WRITE, LCD_DISPLAY_CONTROL | _displayControl, LCD_CMD_LENGTH_8BIT);
+  LCDupdateModes(lcd);
 }
 
 /**************************************************************************/
@@ -290,9 +521,9 @@ void LCDblink(void)
     - text grows from cursor to the left
 */
 /**************************************************************************/
-void LCDscrollDisplayLeft(void)
+void LCDscrollDisplayLeft(LiquidCrystal_I2C *lcd)
 {
-  LCDsend(LCD_INSTRUCTION_WRITE, LCD_CURSOR_DISPLAY_SHIFT | LCD_DISPLAY_SHIFT | LCD_SHIFT_LEFT, LCD_CMD_LENGTH_8BIT);
+  LCDsend(lcd, LCD_INSTRUCTION_WRITE, LCD_CURSOR_DISPLAY_SHIFT | LCD_DISPLAY_SHIFT | LCD_SHIFT_LEFT, LCD_CMD_LENGTH_8BIT); //_displayShift is updated by LCDtrackState()
 }
 
 /**************************************************************************/
@@ -306,9 +537,121 @@ void LCDscrollDisplayLeft(void)
     - text & cursor grows together to the left from cursor position
 */
 /**************************************************************************/
-void LCDscrollDisplayRight(void)
+void LCDscrollDisplayRight(LiquidCrystal_I2C *lcd)
+{
+  LCDsend(lcd, LCD_INSTRUCTION_WRITE, LCD_CURSOR_DISPLAY_SHIFT | LCD_DISPLAY_SHIFT | LCD_SHIFT_RIGHT, LCD_CMD_LENGTH_8BIT);
+}
+
+/**************************************************************************/
+/*
+    LCDmarqueeInit()
+
+    Loads text into DDRAM line of the row for hardware scrolling, see
+    LCDmarqueeStep()
+
+    NOTE:
+    - line is 40 bytes, 80 bytes in 1-line mode of 1 row & 5x10
+      displays, see LCDddramLineSize()
+    - text starts in the first visible colum, text shorter than the
+      line is padded with spaces & loaded only once, longer text is
+      streamed into hidden part of the line while it scrolls
+    - display shift moves all rows together, other rows scroll too, so
+      use it on 1 row displays or if all rows show marquee
+    - on 4 rows displays row 0 & row 2 (row 1 & row 3) share one DDRAM
+      line, marquee overwrites both
+    - text must stay valid while marquee runs
+    - call LCDmarqueeInit() again after LCDclear() or LCDhome(), they
+      reset display shift
+*/
+/**************************************************************************/
+void LCDmarqueeInit(LiquidCrystal_I2C *lcd, lcd_marquee *marquee, uint8_t row, const char *text)
+{
+  bool batch = lcd->_txBatch;
+
+  if (row >= lcd->_lcd_rows) row = (lcd->_lcd_rows - 1);           //safety check
+
+  marquee->text     = text;
+  marquee->length   = strlen(text);
+  marquee->period   = (marquee->length < LCDddramLineSize(lcd)) ? LCDddramLineSize(lcd) : marquee->length;
+  marquee->position = 0;
+  marquee->loaded   = 0;
+  marquee->base     = lcd->_displayShift;                          //text index 0 in the first visible colum
+  marquee->line     = LCDrowAddress(lcd, row, 0) & 0x40;
+
+  if (batch == false) LCDbeginBatch(lcd);
+
+  LCDmarqueeLoad(lcd, marquee);
+
+  if (batch == false) LCDendBatch(lcd);
+}
+
+/**************************************************************************/
+/*
+    LCDmarqueeStep()
+
+    Scrolls marquee one character to the left
+
+    NOTE:
+    - step is one display shift instruction, text longer than the line
+      adds a run of hidden characters once per line size - colums steps
+    - text scrolls in a loop
+*/
+/**************************************************************************/
+void LCDmarqueeStep(LiquidCrystal_I2C *lcd, lcd_marquee *marquee)
+{
+  bool batch = lcd->_txBatch;
+
+  if (batch == false) LCDbeginBatch(lcd);
+
+  LCDscrollDisplayLeft(lcd);
+
+  if (++marquee->position >= marquee->period)
+  {
+    marquee->position -= marquee->period;                          //keep indexes small
+    marquee->loaded   -= marquee->period;
+    marquee->base      = (marquee->base + marquee->period) % LCDddramLineSize(lcd);
+  }
+
+  if ((marquee->loaded - marquee->position) <= lcd->_lcd_colums) LCDmarqueeLoad(lcd, marquee); //next visible character is missing
+
+  if (batch == false) LCDendBatch(lcd);
+}
+
+/**************************************************************************/
+/*
+    LCDmarqueeLoad()
+
+    Writes text from the next unloaded index up to one DDRAM line ahead
+    of the first visible colum
+
+    NOTE:
+    - DDRAM address is set at the start & at the line wrap
+    - text shorter than the line is loaded only once, next period is
+      the same characters in the same slots
+*/
+/**************************************************************************/
+void LCDmarqueeLoad(LiquidCrystal_I2C *lcd, lcd_marquee *marquee)
 {
-  LCDsend(LCD_INSTRUCTION_WRITE, LCD_CURSOR_DISPLAY_SHIFT | LCD_DISPLAY_SHIFT | LCD_SHIFT_RIGHT, LCD_CMD_LENGTH_8BIT);
+  uint16_t index    = 0;
+  uint8_t  slot     = 0;
+  uint8_t  lineSize = LCDddramLineSize(lcd);
+  bool     run      = false;
+
+  if ((marquee->period == lineSize) && (marquee->loaded >= lineSize)) return; //short text is already in DDRAM
+
+  for (; marquee->loaded < (marquee->position + lineSize); marquee->loaded++)
+  {
+    index = marquee->loaded % marquee->period;
+    slot  = (marquee->base + marquee->loaded) % lineSize;
+
+    if ((run == false) || (slot == 0))
+    {
+      LCDsend(lcd, LCD_INSTRUCTION_WRITE, LCD_DDRAM_ADDR_SET | (marquee->line + slot), LCD_CMD_LENGTH_8BIT);
+      run = true;
+    }
+
+    LCDsend(lcd, LCD_DATA_WRITE, (index < marquee->length) ? marquee->text[index] : ' ', LCD_CMD_LENGTH_8BIT);
+  }
 }
 
 /**************************************************************************/
@@ -318,11 +661,11 @@ void LCDscrollDisplayRight(void)
     Sets text direction from left to right
 */
 /**************************************************************************/
-void LCDleftToRight(void)
+void LCDleftToRight(LiquidCrystal_I2C *lcd)
 {
-  _displayMode |= LCD_ENTRY_LEFT;
+  lcd->_displayMode |= LCD_ENTRY_LEFT;
 
-  LCDsend(LCD_INSTRUCTION_WRITE, LCD_ENTRY_MODE_SET | _displayMode, LCD_CMD_LENGTH_8BIT);
+  LCDupdateModes(lcd);
 }
 
 /**************************************************************************/
@@ -332,11 +675,11 @@ void LCDleftToRight(void)
     Sets text direction from right to left
 */
 /**************************************************************************/
-void LCDrightToLeft(void)
+void LCDrightToLeft(LiquidCrystal_I2C *lcd)
 {
-  _displayMode &= ~LCD_ENTRY_LEFT;
+  lcd->_displayMode &= ~LCD_ENTRY_LEFT;
 
-  LCDsend(LCD_INSTRUCTION_WRITE, LCD_ENTRY_MODE_SET | _displayMode, LCD_CMD_LENGTH_8BIT);
+  LCDupdateModes(lcd);
 }
 
 /**************************************************************************/
@@ -351,11 +694,11 @@ void LCDrightToLeft(void)
       call it the loop, just call it once it setup()
 */
 /**************************************************************************/
-void LCDautoscroll(void) 
+void LCDautoscroll(LiquidCrystal_I2C *lcd)
 {
-  _displayMode |= LCD_ENTRY_SHIFT_ON;
+  lcd->_displayMode |= LCD_ENTRY_SHIFT_ON;
 
-  LCDsend(LCD_INSTRUCTION_WRITE, LCD_ENTRY_MODE_SET | _displayMode, LCD_CMD_LENGTH_8BIT);
+  LCDupdateModes(lcd);
 }
 
 
@@ -369,11 +712,11 @@ void LCDautoscroll(void)
     - whole text on the display stays, cursor shifts when byte written
 */
 /**************************************************************************/
-void LCDnoAutoscroll(void)
+void LCDnoAutoscroll(LiquidCrystal_I2C *lcd)
 {
-  _displayMode &= ~LCD_ENTRY_SHIFT_ON;
+  lcd->_displayMode &= ~LCD_ENTRY_SHIFT_ON;
 
-  LCDsend(LCD_INSTRUCTION_WRITE, LCD_ENTRY_MODE_SET | _displayMode, LCD_CMD_LENGTH_8BIT);
+  LCDupdateModes(lcd);
 }
 
 /**************************************************************************/
@@ -386,39 +729,88 @@ void LCDnoAutoscroll(void)
     - 8 patterns for 5x8DOTS display, write address 0..7
       & read address 0..7/8..15
     - 4 patterns for 5x10DOTS display, wrire address 0..3
-      & read address 0..3/0..7
+      & read address 0..7, slot n is shown by codes n*2 & n*2+1,
+      see LCDglyphCode()
+    - same as LCDcreateChars() with one pattern
+*/
+/**************************************************************************/
+void LCDcreateChar(LiquidCrystal_I2C *lcd, uint8_t CGRAM_address, const uint8_t *char_pattern)
+{
+  LCDcreateChars(lcd, CGRAM_address, 1, char_pattern);
+}
+
+/**************************************************************************/
+/*
+    LCDcreateChars()
+
+    Fills CGRAM with several custom characters at once
+
+    NOTE:
+    - patterns follow each other, 8 bytes per pattern for 5x8DOTS &
+      10 bytes per pattern for 5x10DOTS display
+    - 5x8 slots are 8 bytes apart, CGRAM address is set once & the rest
+      uses address counter auto-increment
+    - 5x10 slots are 16 bytes apart, CGRAM address is set for every
+      slot, it is cheaper than 6 padding bytes
+    - all bytes are sent in batch, LCD_TX_BUFFER_SIZE bytes per i2c
+      transaction without command delays, e.g. 8 patterns are 260
+      PCF8574 bytes in 9 transactions, ~6ms @ 400kHz
+    - patterns are read directly by pointer, const arrays stay in flash
+    - address counter points to CGRAM after upload, call LCDsetCursor()
+      before writing text
 */
 /**************************************************************************/
-void LCDcreateChar(uint8_t CGRAM_address, uint8_t *char_pattern)
+void LCDcreateChars(LiquidCrystal_I2C *lcd, uint8_t CGRAM_address, uint8_t count, const uint8_t *char_patterns)
 {
   uint8_t CGRAM_capacity = 0;
-  int8_t  font_size      = 0;
+  uint8_t font_size      = 0;
+  uint8_t slot_size      = 0;
+  bool    batch          = lcd->_txBatch;
 
   /* set CGRAM capacity */
-  switch (_lcd_font_size)
+  switch (lcd->_lcd_font_size)
   {
     case LCD_5x8DOTS:
       CGRAM_capacity = 7;                                                                      //8 patterns, 0..7
       font_size      = 8;
+      slot_size      = 8;
       break;
 
     case LCD_5x10DOTS:
       CGRAM_capacity = 3;                                                                      //4 patterns, 0..3
       font_size      = 10;
+      slot_size      = 16;                                                                     //CGRAM address bits 5..4 select the slot
       break;
   }
 
-  /* safety check, make sure "CGRAM_address" never exceeds the "CGRAM_capacity" */
-  if (CGRAM_address > CGRAM_capacity) CGRAM_address = CGRAM_capacity;
+  /* safety check, make sure "CGRAM_address" & "count" never exceed the "CGRAM_capacity" */
+  if (CGRAM_address > CGRAM_capacity)               CGRAM_address = CGRAM_capacity;
+  if (count > (CGRAM_capacity - CGRAM_address + 1)) count         = CGRAM_capacity - CGRAM_address + 1;
 
-  LCDsend(LCD_INSTRUCTION_WRITE, LCD_CGRAM_ADDR_SET | (CGRAM_address << 3), LCD_CMD_LENGTH_8BIT); //set CGRAM address
+  for (uint8_t i = 0; i < count; i++)
+  {
+    bitClear(lcd->_glyphValid, CGRAM_address + i);                                             //glyph cache copy is outdated, see LCDglyph()
+  }
+
+  memmove(&lcd->_glyphPatterns[CGRAM_address * font_size], char_patterns, count * font_size);   //copy for LCDlinkRestore(), patterns may be the copy itself
+
+  if (batch == false) LCDbeginBatch(lcd);
 
-  for (uint8_t i = 0; i < font_size; i++)
+  for (uint8_t slot = 0; slot < count; slot++)
   {
-    LCDsend(LCD_DATA_WRITE, char_pattern[i], LCD_CMD_LENGTH_8BIT);                                //write data from dynamic memory to CGRAM address
+    if ((slot == 0) || (slot_size != font_size))
+    {
+      LCDsend(lcd, LCD_INSTRUCTION_WRITE, LCD_CGRAM_ADDR_SET | ((CGRAM_address + slot) * slot_size), LCD_CMD_LENGTH_8BIT); //set CGRAM address
+    }
+
+    for (uint8_t i = 0; i < font_size; i++)
+    {
+      LCDsend(lcd, LCD_DATA_WRITE, char_patterns[(slot * font_size) + i], LCD_CMD_LENGTH_8BIT); //write pattern to CGRAM, address counter auto-increment
+    }
   }
-}
 
+  if (batch == false) LCDendBatch(lcd);
+}
 
 /**************************************************************************/
 /*
@@ -429,24 +821,17 @@ void LCDcreateChar(uint8_t CGRAM_address, uint8_t *char_pattern)
     NOTE:
     - doesn't affect lcd controller, because we are working with
       transistor conncted to PCF8574 port
+    - in batch or between LCDbeginModes() & LCDcommitModes() backlight
+      bit rides along with the next command, see LCDsyncBacklight()
 */
 /**************************************************************************/
-void LCDnoBacklight(void)
+void LCDnoBacklight(LiquidCrystal_I2C *lcd)
 {
-  switch (_backlightPolarity)
-  {
-    case POSITIVE:
-      _backlightValue = LCD_BACKLIGHT_OFF;
-      break;
-
-    case NEGATIVE:
-      _backlightValue = ~LCD_BACKLIGHT_OFF;
-      break;
-  }
+  lcd->_backlightValue = LCDbacklightValue(lcd, false);
 
-  _backlightValue <<= _LCD_TO_PCF8574[0];
+  if ((lcd->_txBatch == true) || (lcd->_modesPending == true)) return;
 
-  writePCF8574(PCF8574_ALL_LOW);
+  LCDsyncBacklight(lcd);
 }
 
 /**************************************************************************/
@@ -458,362 +843,3325 @@ void LCDnoBacklight(void)
     NOTE:
     - doesn't affect lcd controller, because we are working with
       transistor conncted to PCF8574 port
+    - in batch or between LCDbeginModes() & LCDcommitModes() backlight
+      bit rides along with the next command, see LCDsyncBacklight()
 */
 /**************************************************************************/
-void LCDbacklight(void)
+void LCDbacklight(LiquidCrystal_I2C *lcd)
 {
-  switch (_backlightPolarity)
-  {
-    case POSITIVE:
-      _backlightValue = LCD_BACKLIGHT_ON;
-      break;
-
-    case NEGATIVE:
-      _backlightValue = ~LCD_BACKLIGHT_ON;
-      break;
-  }
+  lcd->_backlightValue = LCDbacklightValue(lcd, true);
 
-  _backlightValue <<= _LCD_TO_PCF8574[0];
+  if ((lcd->_txBatch == true) || (lcd->_modesPending == true)) return;
 
-  writePCF8574(PCF8574_ALL_LOW);
+  LCDsyncBacklight(lcd);
 }
 
 /**************************************************************************/
 /*
-    LCDwrite()
+    LCDbacklightValue()
 
-    Replaces function "write()" in Arduino class "Print" & sends character
-    to the LCD
+    Returns PCF8574 backlight port bit for backlight state
+
+    NOTE:
+    - NEGATIVE polarity backlight is on when port is low
 */
 /**************************************************************************/
-void LCDwrite(uint8_t value)
+uint8_t LCDbacklightValue(LiquidCrystal_I2C *lcd, bool on)
 {
-  LCDsend(LCD_DATA_WRITE, value, LCD_CMD_LENGTH_8BIT);
+  if (lcd->_backlightPolarity == NEGATIVE) on = !on;
+
+  return (on == true) ? (LCD_BACKLIGHT_ON << lcd->_LCD_TO_PCF8574[0]) : LCD_BACKLIGHT_OFF;
 }
 
 /**************************************************************************/
 /*
-    initialization()
+    LCDsyncBacklight()
 
-    Soft reset lcd & activate 4-bit interface
+    Writes backlight bit to PCF8574 if the last written byte has other
+    backlight state
 
     NOTE:
-    - for correct LCD operation it is necessary to do the internal circuit
-      reset & initialization procedure. See 4-bit initializations
-      procedure fig.24 on p.46 of HD44780 datasheet and p.17 of 
-      WH1602B/WH1604B datasheet for details.
+    - commands carry backlight bit, so backlight change that rode along
+      with them costs nothing, see LCDencode()
+    - E is low after every command, so PCF8574_ALL_LOW keeps lcd idle
+    - returns false if i2c transaction fails
 */
 /**************************************************************************/
-void LCDinitialization(void)
+bool LCDsyncBacklight(LiquidCrystal_I2C *lcd)
 {
-  uint8_t displayFunction = 0; //don't change!!! default bits value DB7, DB6, DB5, DB4=(DL), DB3=(N), DB2=(F), DB1, DB0
+  uint8_t mask = LCD_BACKLIGHT_ON << lcd->_LCD_TO_PCF8574[0];
 
-  /*
-     HD44780 & clones needs ~40ms after voltage rises above 2.7v
-  */
-  HAL_Delay(45);
+  if (lcd->_backend->backlight == false) return true;              //backlight is not driven by the chip
 
-  /*
-     FIRST ATTEMPT: set 8-bit mode
-     - wait > 4.1ms, some LCD even slower than 4.5ms
-     - for Hitachi & Winstar displays
-  */
-  LCDsend(LCD_INSTRUCTION_WRITE, LCD_FUNCTION_SET | LCD_8BIT_MODE, LCD_CMD_LENGTH_4BIT);
-  HAL_Delay(5);
+  if ((lcd->_PCF8574_latchValid == true) && ((lcd->_PCF8574_latch & mask) == lcd->_backlightValue)) return true; //nothing changed
 
-  /*
-     SECOND ATTEMPT: set 8-bit mode
-     - wait > 100us.
-     - for Hitachi, not needed for Winstar displays
-  */
-  LCDsend(LCD_INSTRUCTION_WRITE, LCD_FUNCTION_SET | LCD_8BIT_MODE, LCD_CMD_LENGTH_4BIT);
-  HAL_Delay(1);
-	
-  /*
-     THIRD ATTEMPT: set 8 bit mode
-     - used for Hitachi, not needed for Winstar displays
-  */
-  LCDsend(LCD_INSTRUCTION_WRITE, LCD_FUNCTION_SET | LCD_8BIT_MODE, LCD_CMD_LENGTH_4BIT);
-  HAL_Delay(1);
-	
-  /*
-     FINAL ATTEMPT: set 4-bit interface
-     - Busy Flag (BF) can be checked after this instruction
-  */
-  LCDsend(LCD_INSTRUCTION_WRITE, LCD_FUNCTION_SET | LCD_4BIT_MODE, LCD_CMD_LENGTH_4BIT);
+  return writePCF8574(lcd, PCF8574_ALL_LOW);
+}
 
-  /* sets qnt. of lines */
-  if (_lcd_rows > 1) displayFunction |= LCD_2_LINE;    //line bit located at BD3 & zero/1 line by default
+/**************************************************************************/
+/*
+    LCDwrite()
 
-  /* sets font size, 5x8 by default */
-  if (_lcd_font_size == LCD_5x10DOTS)
+    Replaces function "write()" in Arduino class "Print" & sends character
+    to the LCD
+*/
+/**************************************************************************/
+void LCDwrite(LiquidCrystal_I2C *lcd, uint8_t value)
+{
+  if (lcd->_frameBufferMode == true)
   {
-    displayFunction |= LCD_5x10DOTS;                   //font bit located at BD2
-    if(_lcd_rows != 1) displayFunction &= ~LCD_2_LINE; //safety check, two rows displays can't display 10 pixel font
-  }
-
-  /* initializes lcd functions: qnt. of lines, font size, etc., this settings can't be changed after this point */
-  LCDsend(LCD_INSTRUCTION_WRITE, LCD_FUNCTION_SET | LCD_4BIT_MODE | displayFunction, LCD_CMD_LENGTH_8BIT);
-	
-  /* initializes lcd controls: turn display off, underline cursor off & blinking cursor off */
-  _displayControl = LCD_UNDERLINE_CURSOR_OFF | LCD_BLINK_CURSOR_OFF;
-  LCDnoDisplay();
+    lcd->_frameBuffer[lcd->_frameCursor] = value;
 
-  /* clear display */
-  LCDclear();
+    /* move cursor same way as lcd does, see LCDleftToRight() & LCDrightToLeft() */
+    if (lcd->_displayMode & LCD_ENTRY_LEFT)
+    {
+      if (++lcd->_frameCursor >= (lcd->_lcd_colums * lcd->_lcd_rows)) lcd->_frameCursor = 0;
+    }
+    else
+    {
+      if (lcd->_frameCursor-- == 0) lcd->_frameCursor = (lcd->_lcd_colums * lcd->_lcd_rows) - 1;
+    }
 
-  /* initializes lcd basics: sets text direction "left to right" & cursor movement to the right */
-  _displayMode = LCD_ENTRY_LEFT | LCD_ENTRY_SHIFT_OFF;
-  LCDsend(LCD_INSTRUCTION_WRITE, LCD_ENTRY_MODE_SET | _displayMode, LCD_CMD_LENGTH_8BIT);
+    return;
+  }
 
-  LCDdisplay();
+  LCDsend(lcd, LCD_DATA_WRITE, value, LCD_CMD_LENGTH_8BIT);
 }
 
 /**************************************************************************/
 /*
-    send()
+    LCDwriteBuffer()
+
+    Sends several characters to the LCD from cursor position
+
+    NOTE:
+    - characters are encoded straight into transmit buffer & sent in
+      batch, LCD_TX_BUFFER_SIZE / 4 characters per i2c transaction
+      without command delays
+    - no row wrap, DDRAM address jumps from row 0 to row 2 & etc., see
+      LCDprintWrap()
+*/
+/**************************************************************************/
+void LCDwriteBuffer(LiquidCrystal_I2C *lcd, const uint8_t *buffer, uint16_t length)
+{
+  bool batch = lcd->_txBatch;
+
+  if (batch == false) LCDbeginBatch(lcd);
+
+  while (length-- > 0)
+  {
+    LCDwrite(lcd, *buffer++);
+  }
+
+  if (batch == false) LCDendBatch(lcd);
+}
+
+/**************************************************************************/
+/*
+    LCDprint()
+
+    Sends null-terminated string to the LCD from cursor position
+
+    NOTE:
+    - same as LCDwriteBuffer()
+*/
+/**************************************************************************/
+void LCDprint(LiquidCrystal_I2C *lcd, const char *text)
+{
+  LCDwriteBuffer(lcd, (const uint8_t *)text, strlen(text));
+}
+
+/**************************************************************************/
+/*
+    LCDprintWrap()
+
+    Sends null-terminated string to the LCD from colum, row & wraps it
+    to the next row at the end of the row
+
+    NOTE:
+    - DDRAM address is set only at the start of every row, row address
+      jumps 0x00/0x40/0x14/0x54 for 20x4 are done by LCDrowAddress()
+    - '\n' continues on the next row
+    - after the last row text continues on the first row
+    - text direction has to be left to right, see LCDleftToRight()
+*/
+/**************************************************************************/
+void LCDprintWrap(LiquidCrystal_I2C *lcd, uint8_t colum, uint8_t row, const char *text)
+{
+  bool batch = lcd->_txBatch;
+
+  /* safety check, cursor position is zero indexed */
+  if (row   >= lcd->_lcd_rows)   row   = (lcd->_lcd_rows   - 1);
+  if (colum >= lcd->_lcd_colums) colum = (lcd->_lcd_colums - 1);
+
+  if (batch == false) LCDbeginBatch(lcd);
+
+  LCDsetCursor(lcd, colum, row);
+
+  while (*text != '\0')
+  {
+    if ((colum >= lcd->_lcd_colums) || (*text == '\n'))
+    {
+      colum = 0;
+      if (++row >= lcd->_lcd_rows) row = 0;
+
+      LCDsetCursor(lcd, colum, row);
+
+      if (*text == '\n')
+      {
+        text++;
+        continue;
+      }
+    }
+
+    LCDwrite(lcd, *text++);
+    colum++;
+  }
+
+  if (batch == false) LCDendBatch(lcd);
+}
+
+/**************************************************************************/
+/*
+    LCDprintInt()
+
+    Prints integer from cursor position, right aligned to width
+
+    NOTE:
+    - width = 0, no padding
+    - number wider than width is printed as "*" * width
+    - no printf, characters are sent by LCDwriteBuffer()
+*/
+/**************************************************************************/
+void LCDprintInt(LiquidCrystal_I2C *lcd, int32_t value, uint8_t width)
+{
+  LCDprintFixed(lcd, value, 0, width);
+}
+
+/**************************************************************************/
+/*
+    LCDprintFixed()
+
+    Prints fixed point number from cursor position, right aligned to
+    width
+
+    NOTE:
+    - value is scaled by 10^decimals, e.g. value = -1234 & decimals = 2
+      is printed as "-12.34"
+    - see LCDprintInt() for width
+*/
+/**************************************************************************/
+void LCDprintFixed(LiquidCrystal_I2C *lcd, int32_t value, uint8_t decimals, uint8_t width)
+{
+  char    buffer[LCD_NUMBER_SIZE];
+  uint8_t length = 0;
+
+  length = LCDformatNumber(buffer, (value < 0) ? (0 - (uint32_t)value) : (uint32_t)value, value < 0, decimals, 10, width);
+
+  LCDwriteBuffer(lcd, (const uint8_t *)buffer, length);
+}
+
+/**************************************************************************/
+/*
+    LCDprintHex()
+
+    Prints hexadecimal number from cursor position, padded with zeros
+    to width
+
+    NOTE:
+    - see LCDprintInt() for width
+*/
+/**************************************************************************/
+void LCDprintHex(LiquidCrystal_I2C *lcd, uint32_t value, uint8_t width)
+{
+  char    buffer[LCD_NUMBER_SIZE];
+  uint8_t length = 0;
+
+  length = LCDformatNumber(buffer, value, false, 0, 16, width);
+
+  LCDwriteBuffer(lcd, (const uint8_t *)buffer, length);
+}
+
+/**************************************************************************/
+/*
+    LCDformatNumber()
+
+    Formats number into buffer & returns qnt. of characters
+
+    NOTE:
+    - decimal number is padded with spaces, hexadecimal with zeros
+    - width is cut to LCD_NUMBER_SIZE, buffer is not null-terminated
+*/
+/**************************************************************************/
+uint8_t LCDformatNumber(char *buffer, uint32_t value, bool negative, uint8_t decimals, uint8_t base, uint8_t width)
+{
+  char    digits[LCD_NUMBER_SIZE];                               //reversed
+  uint8_t length = 0;
+  uint8_t digit  = 0;
+  char    pad    = (base == 16) ? '0' : ' ';
+
+  if (width    > LCD_NUMBER_SIZE)       width    = LCD_NUMBER_SIZE;  //safety check, make sure number fits into the buffer
+  if (decimals > (LCD_NUMBER_SIZE - 3)) decimals = LCD_NUMBER_SIZE - 3;
+
+  do
+  {
+    if ((length == decimals) && (decimals != 0)) digits[length++] = '.';
+
+    digit            = value % base;
+    digits[length++] = (digit < 10) ? ('0' + digit) : ('A' + digit - 10);
+    value           /= base;
+  }
+  while (((value != 0) || (length <= decimals)) && (length < LCD_NUMBER_SIZE));
+
+  if ((negative == true) && (length < LCD_NUMBER_SIZE)) digits[length++] = '-';
+
+  if (width == 0) width = length;
+
+  if (length > width)
+  {
+    memset(buffer, '*', width);                                   //number doesn't fit
+    return width;
+  }
+
+  memset(buffer, pad, width - length);
+
+  for (uint8_t i = 0; i < length; i++)
+  {
+    buffer[width - 1 - i] = digits[i];
+  }
+
+  return width;
+}
+
+/**************************************************************************/
+/*
+    LCDfieldInit()
+
+    Sets position, width & decimals of number field
+
+    NOTE:
+    - width is cut to LCD_NUMBER_SIZE & to fit the row
+    - first update draws the field in full
+*/
+/**************************************************************************/
+void LCDfieldInit(LiquidCrystal_I2C *lcd, lcd_number_field *field, uint8_t colum, uint8_t row, uint8_t width, uint8_t decimals)
+{
+  /* safety check, field has to fit the screen */
+  if (row   >= lcd->_lcd_rows)                  row   = (lcd->_lcd_rows   - 1);
+  if (colum >= lcd->_lcd_colums)                colum = (lcd->_lcd_colums - 1);
+  if (width > LCD_NUMBER_SIZE)                  width = LCD_NUMBER_SIZE;
+  if (width > (lcd->_lcd_colums - colum))       width = lcd->_lcd_colums - colum;
+  if (width == 0)                               width = 1;
+
+  field->colum    = colum;
+  field->row      = row;
+  field->width    = width;
+  field->decimals = decimals;
+  field->epoch    = lcd->_graphEpoch - 1;                        //field is not drawn yet
+}
+
+/**************************************************************************/
+/*
+    LCDfieldInt()
+
+    Updates number field with integer or fixed point value, see
+    LCDprintFixed()
+
+    NOTE:
+    - only changed characters are sent, e.g. 1234 -> 1235 is one
+      cursor set & one character
+*/
+/**************************************************************************/
+void LCDfieldInt(LiquidCrystal_I2C *lcd, lcd_number_field *field, int32_t value)
+{
+  char text[LCD_NUMBER_SIZE];
+
+  LCDformatNumber(text, (value < 0) ? (0 - (uint32_t)value) : (uint32_t)value, value < 0, field->decimals, 10, field->width);
+
+  LCDfieldUpdate(lcd, field, text);
+}
+
+/**************************************************************************/
+/*
+    LCDfieldHex()
+
+    Updates number field with hexadecimal value, see LCDfieldInt()
+*/
+/**************************************************************************/
+void LCDfieldHex(LiquidCrystal_I2C *lcd, lcd_number_field *field, uint32_t value)
+{
+  char text[LCD_NUMBER_SIZE];
+
+  LCDformatNumber(text, value, false, 0, 16, field->width);
+
+  LCDfieldUpdate(lcd, field, text);
+}
+
+/**************************************************************************/
+/*
+    LCDfieldUpdate()
+
+    Sends characters of number field different from the last drawn
+
+    NOTE:
+    - DDRAM address is set only at the start of every run of changed
+      characters
+*/
+/**************************************************************************/
+void LCDfieldUpdate(LiquidCrystal_I2C *lcd, lcd_number_field *field, const char *text)
+{
+  bool batch = lcd->_txBatch;
+  bool full  = (field->epoch != lcd->_graphEpoch);
+  bool run   = false;
+
+  if ((full == false) && (memcmp(field->text, text, field->width) == 0)) return; //nothing changed
+
+  if (batch == false) LCDbeginBatch(lcd);
+
+  for (uint8_t i = 0; i < field->width; i++)
+  {
+    if ((full == false) && (field->text[i] == text[i]))
+    {
+      run = false;
+      continue;
+    }
+
+    if (run == false) LCDsetCursor(lcd, field->colum + i, field->row);
+
+    LCDwrite(lcd, text[i]);
+    run = true;
+  }
+
+  if (batch == false) LCDendBatch(lcd);
+
+  memcpy(field->text, text, field->width);
+
+  field->epoch = lcd->_graphEpoch;
+}
+
+/**************************************************************************/
+/*
+    initialization()
+
+    Soft reset lcd & activate 4-bit interface
+
+    NOTE:
+    - for correct LCD operation it is necessary to do the internal circuit
+      reset & initialization procedure. See 4-bit initializations
+      procedure fig.24 on p.46 of HD44780 datasheet and p.17 of 
+      WH1602B/WH1604B datasheet for details.
+    - see LCDinitializationPanels()
+*/
+/**************************************************************************/
+void LCDinitialization(LiquidCrystal_I2C *lcd)
+{
+  LCDinitializationPanels(&lcd, 1, 0x0001);
+}
+
+/**************************************************************************/
+/*
+    LCDinitializationPanels()
+
+    Soft reset & 4-bit interface of several lcd at once
+
+    NOTE:
+    - ready is bit per panel, panels with cleared bit are skipped
+    - every step is sent to all panels before the wait, so panels share
+      one power-on, reset & clear wait
+    - power-on wait is shortened by time since MCU power-up, if bus
+      backend knows it, lcd & MCU are expected to share power supply
+    - reset nibbles are streamed in batch, only waits required by
+      datasheet are done, see LCD_RESET_DELAY & LCD_RESET_NIBBLE_DELAY
+    - shared waits are counted by statistics of the first panel
+    - clear wait is extended to the longest backend extensionDelay, e.g.
+      ST7032 follower, panels share it too
+*/
+/**************************************************************************/
+void LCDinitializationPanels(LiquidCrystal_I2C *const *panels, uint8_t count, uint16_t ready)
+{
+  uint32_t uptime = 0;
+  uint16_t wait   = LCD_HOME_CLEAR_DELAY;            //in milliseconds
+
+  /*
+     HD44780 & clones needs ~40ms after voltage rises above 2.7v
+  */
+  if (panels[0]->_bus->uptime != NULL) uptime = panels[0]->_bus->uptime();
+
+  if (uptime < LCD_POWER_ON_DELAY) LCDdelay(panels[0], (LCD_POWER_ON_DELAY - uptime) * 1000);
+
+  /*
+     FIRST ATTEMPT: set 8-bit mode
+     - wait > 4.1ms, some LCD even slower than 4.5ms
+     - for Hitachi & Winstar displays
+  */
+  for (uint8_t i = 0; i < count; i++)
+  {
+    if (bitRead(ready, i) == 0) continue;
+
+    LCDbeginBatch(panels[i]);
+    LCDsend(panels[i], LCD_INSTRUCTION_WRITE, LCD_FUNCTION_SET | LCD_8BIT_MODE, LCD_CMD_LENGTH_4BIT);
+    LCDflushTxBuffer(panels[i]);
+  }
+
+  LCDdelay(panels[0], LCD_RESET_DELAY);              //from the last panel, the others wait longer
+
+  /*
+     SECOND ATTEMPT: set 8-bit mode
+     - wait > 100us.
+     - for Hitachi, not needed for Winstar displays
+  */
+  for (uint8_t i = 0; i < count; i++)
+  {
+    if (bitRead(ready, i) == 0) continue;
+
+    LCDsend(panels[i], LCD_INSTRUCTION_WRITE, LCD_FUNCTION_SET | LCD_8BIT_MODE, LCD_CMD_LENGTH_4BIT);
+    LCDflushTxBuffer(panels[i]);
+  }
+
+  LCDdelay(panels[0], LCD_RESET_NIBBLE_DELAY);
+
+  for (uint8_t i = 0; i < count; i++)
+  {
+    if (bitRead(ready, i) == 0) continue;
+
+    LCDresetInterface(panels[i]);
+    LCDconfigurationStart(panels[i]);                //modes go out in the same i2c transaction
+
+    if (panels[i]->_backend->extensionDelay > wait) wait = panels[i]->_backend->extensionDelay; //e.g. ST7032 voltage follower, display is turned on after it
+  }
+
+  for (; wait > 50; wait -= 50) LCDdelay(panels[0], 50000); //delay is 16-bit, in microseconds
+
+  LCDdelay(panels[0], wait * 1000);                  //clear duration
+
+  for (uint8_t i = 0; i < count; i++)
+  {
+    if (bitRead(ready, i) == 0) continue;
+
+    LCDconfigurationEnd(panels[i]);
+    LCDflushBatch(panels[i]);                        //command duration is covered by transfer of the next panel
+  }
+
+  LCDdelay(panels[0], LCD_COMMAND_DELAY);            //duration of the last command
+}
+
+/**************************************************************************/
+/*
+    LCDresetInterface()
+
+    Last two soft reset instructions, interface & controller extension
+    commands, see LCDinitializationPanels()
+
+    NOTE:
+    - called in batch mode after 2-nd soft reset nibble & its wait
+    - caller waits backend extensionDelay before display is turned on
+*/
+/**************************************************************************/
+void LCDresetInterface(LiquidCrystal_I2C *lcd)
+{
+  /*
+     THIRD ATTEMPT: set 8 bit mode
+     - used for Hitachi, not needed for Winstar displays
+     - 37us command duration is covered by i2c transfer of the next two
+       PCF8574 bytes, same as in batch mode
+  */
+  LCDsend(lcd, LCD_INSTRUCTION_WRITE, LCD_FUNCTION_SET | LCD_8BIT_MODE, LCD_CMD_LENGTH_4BIT);
+
+  /*
+     FINAL ATTEMPT: set 4-bit interface, 8-bit backends stay in 8-bit
+     - Busy Flag (BF) can be checked after this instruction
+  */
+  LCDsend(lcd, LCD_INSTRUCTION_WRITE, LCD_FUNCTION_SET | lcd->_backend->interface, LCD_CMD_LENGTH_4BIT);
+
+  if (lcd->_backend->extension != NULL) lcd->_backend->extension(lcd); //e.g. ST7032 power circuits
+}
+
+/**************************************************************************/
+/*
+    LCDconfiguration()
+
+    Sets lines, font, display controls & text direction of lcd in 4-bit
+    mode & clears it
+
+    NOTE:
+    - called in batch mode, the only wait is clear command duration
+*/
+/**************************************************************************/
+void LCDconfiguration(LiquidCrystal_I2C *lcd)
+{
+  LCDconfigurationStart(lcd);
+  LCDwaitReady(lcd, LCD_HOME_CLEAR_DELAY * 1000);
+  LCDconfigurationEnd(lcd);
+}
+
+/**************************************************************************/
+/*
+    LCDconfigurationStart()
+
+    Sends lines, font, display off, text direction & clear commands,
+    see LCDconfiguration()
+
+    NOTE:
+    - called in batch mode, caller waits for clear command duration
+    - entry mode is set before clear, clear does not change it
+*/
+/**************************************************************************/
+void LCDconfigurationStart(LiquidCrystal_I2C *lcd)
+{
+  uint8_t displayFunction = 0; //don't change!!! default bits value DB7, DB6, DB5, DB4=(DL), DB3=(N), DB2=(F), DB1, DB0
+
+  /* sets qnt. of lines */
+  if (lcd->_lcd_rows > 1) displayFunction |= LCD_2_LINE; //line bit located at BD3 & zero/1 line by default
+
+  /* sets font size, 5x8 by default */
+  if (lcd->_lcd_font_size == LCD_5x10DOTS)
+  {
+    displayFunction |= LCD_5x10DOTS;                   //font bit located at BD2
+    if(lcd->_lcd_rows != 1) displayFunction &= ~LCD_2_LINE; //safety check, two rows displays can't display 10 pixel font
+  }
+
+  /* initializes lcd functions: qnt. of lines, font size, etc., this settings can't be changed after this point */
+  LCDsend(lcd, LCD_INSTRUCTION_WRITE, LCD_FUNCTION_SET | lcd->_backend->interface | displayFunction, LCD_CMD_LENGTH_8BIT);
+	
+  /* lcd registers are unknown, both are sent */
+  lcd->_displayControlSent = LCD_MODE_UNKNOWN;
+  lcd->_displayModeSent    = LCD_MODE_UNKNOWN;
+  lcd->_modesPending       = false;
+
+  /* initializes lcd controls: turn display off, underline cursor off & blinking cursor off */
+  lcd->_displayControl = LCD_DISPLAY_OFF | LCD_UNDERLINE_CURSOR_OFF | LCD_BLINK_CURSOR_OFF;
+
+  /* initializes lcd basics: sets text direction "left to right" & cursor movement to the right */
+  lcd->_displayMode = LCD_ENTRY_LEFT | LCD_ENTRY_SHIFT_OFF;
+
+  LCDupdateModes(lcd);
+
+  /* clear display, sends whole stream */
+  LCDsend(lcd, LCD_INSTRUCTION_WRITE, LCD_CLEAR_DISPLAY, LCD_CMD_LENGTH_8BIT);
+  LCDflushTxBuffer(lcd);
+}
+
+/**************************************************************************/
+/*
+    LCDconfigurationEnd()
+
+    Turns display on after clear & resets driver copies of lcd content,
+    see LCDconfiguration()
+*/
+/**************************************************************************/
+void LCDconfigurationEnd(LiquidCrystal_I2C *lcd)
+{
+  LCDdisplay(lcd);
+
+  LCDgraphReset(lcd);                                //display shift & _frameScreen are reset by clear, see LCDtrackState()
+  LCDglyphCache(lcd, 0, 8);                           //CGRAM content is unknown, whole CGRAM is cached by default
+}
+
+/**************************************************************************/
+/*
+    send()
 
     The most anvanced & fastes way to write COMMAND or DATA/TEXT to LCD
     
     NOTE:
-    - all inputs formated as follow: 
-      - mode : RS,RW,E=1,DB7,DB6,DB5,DB4,BCK_LED=0
-      - value: DB7,DB6,DB5,DB4,DB3,DB2,DB1,DB0
+    - all inputs formated as follow: 
+      - mode : RS,RW,E=1,DB7,DB6,DB5,DB4,BCK_LED=0
+      - value: DB7,DB6,DB5,DB4,DB3,DB2,DB1,DB0
+
+    - command is encoded by backend, e.g. into E-high/E-low PCF8574 bytes,
+      & stored in transmit buffer, whole buffer is sent in one i2c
+      transaction, see LCDbackend()
+    - in batch mode the buffer is sent by LCDendBatch() or when it is full,
+      otherwise it is sent right away
+    - returns false if command is lost, after the first i2c error the rest
+      of the batch is dropped without bus transactions, see LCDlinkService()
+    - duration of command > 43usec for GDM2004D
+    - duration of the En pulse > 450nsec
+*/
+/**************************************************************************/
+bool LCDsend(LiquidCrystal_I2C *lcd, uint8_t mode, uint8_t value, uint8_t length)
+{
+  bool    success = true;
+  uint8_t size    = 0;
+
+  if ((lcd->_txLength + 4) > LCD_TX_BUFFER_SIZE) LCDflushTxBuffer(lcd); //safety check, make sure 8-bit command fits into the buffer
+
+  size = lcd->_backend->encode(lcd, mode, value, length, &lcd->_txBuffer[lcd->_txLength]);
+
+  if (size == 0)                                     //command can't follow data stream of native controller
+  {
+    LCDflushTxBuffer(lcd);
+    size = lcd->_backend->encode(lcd, mode, value, length, &lcd->_txBuffer[lcd->_txLength]);
+  }
+
+  lcd->_txLength += size;
+
+  LCDtrackState(lcd, mode, value, length);
+
+  if (lcd->_txBatch == true) return (lcd->_linkFault == false); //in batch mode next two i2c bytes (>45usec @ 400kHz) cover command duration
+
+  success = LCDflushTxBuffer(lcd);
+  LCDwaitReady(lcd, LCD_COMMAND_DELAY);              //command duration
+
+  return success;
+}
+
+/**************************************************************************/
+/*
+    LCDencode()
+
+    Encodes COMMAND or DATA/TEXT into E-high/E-low PCF8574 bytes
+
+    NOTE:
+    - see LCDsend() for inputs format
+    - buffer must have space for 4 bytes
+    - returns qnt. of encoded bytes, 2 for 4-bit & 4 for 8-bit command
+*/
+/**************************************************************************/
+uint8_t LCDencode(LiquidCrystal_I2C *lcd, uint8_t mode, uint8_t value, uint8_t length, uint8_t *buffer)
+{
+  uint8_t  halfByte = 0; //lsb or msb
+  uint8_t  data     = 0;
+
+  /* 4-bit or 1-st part of 8-bit command */
+  halfByte  = value >> 3;                            //0,0,0,DB7,DB6,DB5,DB4,DB3
+  halfByte &= 0x1E;                                  //0,0,0,DB7,DB6,DB5,DB4,BCK_LED=0
+  data      = LCDportMapping(lcd, mode | halfByte);  //RS,RW,E=1,DB7,DB6,DB5,DB4,BCK_LED=0
+
+  buffer[0] = data | lcd->_backlightValue;           //send command
+                                                     //En pulse duration > 450nsec
+  bitClear(data, lcd->_LCD_TO_PCF8574[5]);           //RS,RW,E=0,DB7,DB6,DB5,DB4,BCK_LED=0
+  buffer[1] = data | lcd->_backlightValue;           //execute command
+
+  if (length != LCD_CMD_LENGTH_8BIT) return 2;
+
+  /* second part of 8-bit command */
+  halfByte  = value << 1;                            //DB6,DB5,DB4,DB3,DB2,DB1,DB0,0
+  halfByte &= 0x1E;                                  //0,0,0,DB3,DB2,DB1,DB0,BCK_LED=0
+  data      = LCDportMapping(lcd, mode | halfByte);  //RS,RW,E=1,DB3,DB2,DB1,DB0,BCK_LED=0
+
+  buffer[2] = data | lcd->_backlightValue;           //send command
+                                                     //En pulse duration > 450nsec
+  bitClear(data, lcd->_LCD_TO_PCF8574[5]);           //RS,RW,E=0,DB3,DB2,DB1,DB0,BCK_LED=0
+  buffer[3] = data | lcd->_backlightValue;           //execute command
+
+  return 4;
+}
+
+/**************************************************************************/
+/*
+    LCDencodeMCP23017()
+
+    Encodes COMMAND or DATA/TEXT into GPIOB/GPIOA bytes of MCP23017 in
+    byte mode, see LCDbackend()
+
+    NOTE:
+    - see LCDsend() for inputs format
+    - port B is DB7..DB0, port A is RS,RW,E & BCK_LED mapped as PCF8574
+    - register pointer toggles B,A,B,A, so E-high & E-low both carry data
+    - 4-bit commands of soft reset are sent as is, DB3..DB0 are zero
+*/
+/**************************************************************************/
+uint8_t LCDencodeMCP23017(LiquidCrystal_I2C *lcd, uint8_t mode, uint8_t value, uint8_t length, uint8_t *buffer)
+{
+  uint8_t control = LCDportMapping(lcd, mode) | lcd->_backlightValue; //RS,RW,E=1,BCK_LED
+
+  (void)length;
+
+  buffer[0] = value;                                 //GPIOB, DB7..DB0
+  buffer[1] = control;                               //GPIOA, send command
+  buffer[2] = value;                                 //GPIOB, En pulse duration > 450nsec
+  bitClear(control, lcd->_LCD_TO_PCF8574[5]);        //RS,RW,E=0,BCK_LED
+  buffer[3] = control;                               //GPIOA, execute command
+
+  return 4;
+}
+
+/**************************************************************************/
+/*
+    LCDencodeNative()
+
+    Encodes COMMAND or DATA/TEXT for ST7032 & AiP31068 controllers with
+    built-in i2c, see LCDbackend()
+
+    NOTE:
+    - see LCDsend() for inputs format
+    - command is control byte with Co=1 & command byte
+    - data write longer than one i2c byte, see dataDelay of backend, is
+      control byte with Co=1 & data byte, 2 bytes cover it @ 400kHz
+    - otherwise first data byte opens data stream (Co=0), the rest of
+      data takes 1 byte per character till the end of transaction
+    - returns 0 for command after data stream, LCDsend() starts new
+      transaction
+*/
+/**************************************************************************/
+uint8_t LCDencodeNative(LiquidCrystal_I2C *lcd, uint8_t mode, uint8_t value, uint8_t length, uint8_t *buffer)
+{
+  (void)length;
+
+  if ((mode == LCD_DATA_WRITE) && (lcd->_backend->dataDelay > LCD_I2C_BYTE_TIME)) //stream is faster than controller
+  {
+    buffer[0] = LCD_NATIVE_DATA;
+    buffer[1] = value;
+    return 2;
+  }
+
+  if (mode == LCD_DATA_WRITE)
+  {
+    if (lcd->_txStream == true)
+    {
+      buffer[0] = value;
+      return 1;
+    }
+
+    lcd->_txStream = true;
+
+    buffer[0] = LCD_NATIVE_DATA_STREAM;
+    buffer[1] = value;
+    return 2;
+  }
+
+  if (lcd->_txStream == true) return 0;              //Co=0 is the last control byte of transaction
+
+  buffer[0] = LCD_NATIVE_COMMAND;
+  buffer[1] = value;
+
+  return 2;
+}
+
+/**************************************************************************/
+/*
+    LCDtrackState()
+
+    Updates software copy of lcd address counter, display control &
+    entry mode registers after COMMAND or DATA/TEXT, so LCDsetCursor()
+    & mode setters can skip commands that change nothing
+
+    NOTE:
+    - see LCDsend() for inputs format
+    - data write moves address counter in text direction of entry mode
+      register, see LCDnextAddress()
+    - 4-bit commands of soft reset make address unknown
+    - clear sets I/D bit to increment, text direction of _displayMode
+      is set to "left to right" too, see p.24 of HD44780 datasheet
+    - data write to visible DDRAM cell updates _frameScreen, so screen
+      can be restored after i2c link loss, see LCDlinkRestore()
+    - display shift instruction & DDRAM data write with S=1 (autoscroll)
+      move _displayShift, I/D=1 shifts left, clear & home reset it,
+      CGRAM write never shifts, see LCDshiftTrack()
+    - LCDgetCursorPosition() reads address counter back if model got
+      out of sync, e.g. after i2c error
+*/
+/**************************************************************************/
+void LCDtrackState(LiquidCrystal_I2C *lcd, uint8_t mode, uint8_t value, uint8_t length)
+{
+  if (length != LCD_CMD_LENGTH_8BIT)
+  {
+    lcd->_addressCounter = LCD_ADDRESS_UNKNOWN;
+    return;
+  }
+
+  if (mode == LCD_DATA_WRITE)
+  {
+    uint8_t index = LCDscreenIndex(lcd, lcd->_addressCounter);
+
+    if ((index != LCD_ADDRESS_UNKNOWN) && (lcd->_frameScreenValid == true)) lcd->_frameScreen[index] = value;
+
+    if      (lcd->_addressCounter  >= LCD_ADDRESS_CGRAM) return;   //CGRAM address is not tracked
+    else if (lcd->_displayModeSent == LCD_MODE_UNKNOWN)  lcd->_addressCounter = LCD_ADDRESS_UNKNOWN;
+    else                                                 lcd->_addressCounter = LCDnextAddress(lcd, lcd->_addressCounter, lcd->_displayModeSent & LCD_ENTRY_LEFT);
+
+    if ((lcd->_displayModeSent != LCD_MODE_UNKNOWN) && (lcd->_displayModeSent & LCD_ENTRY_SHIFT_ON)) LCDshiftTrack(lcd, lcd->_displayModeSent & LCD_ENTRY_LEFT); //autoscroll
+    return;
+  }
+
+  if      (value & LCD_DDRAM_ADDR_SET)         lcd->_addressCounter = value & 0x7F;
+  else if (value & LCD_CGRAM_ADDR_SET)         lcd->_addressCounter = LCD_ADDRESS_CGRAM;
+  else if (value & LCD_FUNCTION_SET)           return;            //no effect on address counter
+  else if (value & LCD_CURSOR_DISPLAY_SHIFT)
+  {
+    if (value & LCD_DISPLAY_SHIFT)
+    {
+      LCDshiftTrack(lcd, (value & LCD_SHIFT_RIGHT) == 0);        //display shift keeps address counter
+      return;
+    }
+
+    if (lcd->_addressCounter >= LCD_ADDRESS_CGRAM) return;
+
+    lcd->_addressCounter = LCDnextAddress(lcd, lcd->_addressCounter, value & LCD_SHIFT_RIGHT);
+  }
+  else if (value & LCD_DISPLAY_CONTROL)        lcd->_displayControlSent = value & 0x07;
+  else if (value & LCD_ENTRY_MODE_SET)         lcd->_displayModeSent    = value & 0x03;
+  else if (value & LCD_RETURN_HOME)
+  {
+    lcd->_addressCounter = 0x00;
+    lcd->_displayShift   = 0;
+  }
+  else if (value & LCD_CLEAR_DISPLAY)
+  {
+    lcd->_addressCounter  = 0x00;
+    lcd->_displayShift    = 0;
+    lcd->_displayMode    |= LCD_ENTRY_LEFT;                      //lcd switches to increment mode
+    lcd->_displayModeSent = (lcd->_displayModeSent == LCD_MODE_UNKNOWN) ? LCD_MODE_UNKNOWN : (lcd->_displayModeSent | LCD_ENTRY_LEFT);
+
+    memset(lcd->_frameScreen, 0x20, sizeof(lcd->_frameScreen));  //DDRAM is filled with spaces
+    lcd->_frameScreenValid = true;
+  }
+}
+
+/**************************************************************************/
+/*
+    LCDshiftTrack()
+
+    Moves software copy of display shift, left shift shows next colum
+
+    NOTE:
+    - wraps at the end of DDRAM line, see LCDddramLineSize()
+*/
+/**************************************************************************/
+void LCDshiftTrack(LiquidCrystal_I2C *lcd, bool left)
+{
+  if (left == true)
+  {
+    if (++lcd->_displayShift >= LCDddramLineSize(lcd)) lcd->_displayShift = 0;
+    return;
+  }
+
+  if (lcd->_displayShift-- == 0) lcd->_displayShift = LCDddramLineSize(lcd) - 1;
+}
+
+/**************************************************************************/
+/*
+    LCDscreenIndex()
+
+    Returns screen cell of DDRAM address, row by row same as _frameScreen[]
+
+    NOTE:
+    - returns LCD_ADDRESS_UNKNOWN if address is out of the screen
+    - display shift is ignored, see LCDscrollDisplayLeft()
+*/
+/**************************************************************************/
+uint8_t LCDscreenIndex(LiquidCrystal_I2C *lcd, uint8_t address)
+{
+  uint8_t base = 0;
+
+  if (address >= LCD_ADDRESS_CGRAM) return LCD_ADDRESS_UNKNOWN;
+
+  for (uint8_t row = 0; row < lcd->_lcd_rows; row++)
+  {
+    base = LCDrowAddress(lcd, row, 0);
+
+    if ((address >= base) && (address < (base + lcd->_lcd_colums))) return (row * lcd->_lcd_colums) + (address - base);
+  }
+
+  return LCD_ADDRESS_UNKNOWN;
+}
+
+/**************************************************************************/
+/*
+    LCDnextAddress()
+
+    Returns DDRAM address after one increment or decrement of address
+    counter
+
+    NOTE:
+    - 2 lines mode has 0x00..0x27 & 0x40..0x67 address ranges, end of
+      one line wraps to the start of the other
+    - 1 line mode has 0x00..0x4F address range
+*/
+/**************************************************************************/
+uint8_t LCDnextAddress(LiquidCrystal_I2C *lcd, uint8_t address, bool increment)
+{
+  if ((lcd->_lcd_rows > 1) && (lcd->_lcd_font_size != LCD_5x10DOTS)) //same as lines setup in LCDinitialization()
+  {
+    if (increment == true)
+    {
+      if (address == 0x27) return 0x40;
+      if (address == 0x67) return 0x00;
+
+      return address + 1;
+    }
+
+    if (address == 0x00) return 0x67;
+    if (address == 0x40) return 0x27;
+
+    return address - 1;
+  }
+
+  if (increment == true) return (address >= 0x4F) ? 0x00 : (address + 1);
+
+  return (address == 0x00) ? 0x4F : (address - 1);
+}
+
+/**************************************************************************/
+/*
+    LCDddramLineSize()
+
+    Returns DDRAM bytes per line, display shift wraps at the end of it
+
+    NOTE:
+    - 2 lines mode has two 40 bytes lines, 1 line mode of 1 row & 5x10
+      displays has one 80 bytes line, see LCDnextAddress()
+*/
+/**************************************************************************/
+uint8_t LCDddramLineSize(LiquidCrystal_I2C *lcd)
+{
+  if ((lcd->_lcd_rows > 1) && (lcd->_lcd_font_size != LCD_5x10DOTS)) return LCD_DDRAM_LINE_SIZE; //same as LCDnextAddress()
+
+  return LCD_DDRAM_1LINE_SIZE;
+}
+
+/**************************************************************************/
+/*
+    LCDbeginBatch()
+
+    Starts collecting commands & data into transmit buffer instead of
+    sending every character in separate i2c transaction
+
+    NOTE:
+    - call LCDendBatch() to send the rest of the buffer
+    - no delay between commands in batch, command duration is covered
+      by i2c transfer of the next two PCF8574 bytes, valid for i2c
+      clock up to 400kHz
+    - clear & home commands flush the buffer & wait as usual
+*/
+/**************************************************************************/
+void LCDbeginBatch(LiquidCrystal_I2C *lcd)
+{
+  lcd->_txBatch = true;
+}
+
+/**************************************************************************/
+/*
+    LCDendBatch()
+
+    Sends collected commands & data to LCD & returns to normal mode
+
+    NOTE:
+    - returns false if i2c transaction fails
+*/
+/**************************************************************************/
+bool LCDendBatch(LiquidCrystal_I2C *lcd)
+{
+  bool status = LCDflushBatch(lcd);
+
+  LCDwaitReady(lcd, LCD_COMMAND_DELAY);         //duration of the last command
+
+  return status;
+}
+
+/**************************************************************************/
+/*
+    LCDflushBatch()
+
+    Same as LCDendBatch(), but without wait for the last command
+
+    NOTE:
+    - caller has to cover the last command duration, e.g. by transfer
+      to other panel, see LCDflushPanels()
+    - backlight changed during batch is written if no command carried
+      it, see LCDsyncBacklight()
+*/
+/**************************************************************************/
+bool LCDflushBatch(LiquidCrystal_I2C *lcd)
+{
+  bool status = LCDflushTxBuffer(lcd);
+
+  lcd->_txBatch = false;
+
+  if (lcd->_modesPending == false) status &= LCDsyncBacklight(lcd);
+
+  return status;
+}
+
+/**************************************************************************/
+/*
+    LCDflushTxBuffer()
+
+    Sends all encoded PCF8574 bytes from transmit buffer in one i2c
+    transaction
+
+    NOTE:
+    - buffer is emptied even if transaction fails
+    - failed transaction opens circuit breaker, buffer is dropped without
+      bus transaction until LCDlinkService() restores the display
+    - busy bus is waited for, see LCDbusWrite(), bus that stays busy
+      drops the buffer but doesn't open circuit breaker, tracked lcd
+      state becomes unknown, see LCDtrackLost()
+    - waits for async queue, see LCDflushAsync()
+*/
+/**************************************************************************/
+bool LCDflushTxBuffer(LiquidCrystal_I2C *lcd)
+{
+  lcd_bus_status status = LCD_BUS_OK;
+
+  if (lcd->_txLength == lcd->_txStart) return true;
+
+  lcd->_txStream = false;
+
+  if (lcd->_linkFault == true)
+  {
+    lcd->_txLength = lcd->_txStart;                       //display is not responding, skip timeout of every transaction
+    return false;
+  }
+
+  while (LCDasyncBusy(lcd) == true) LCDasyncService(lcd); //safety check, async queue owns the bus until it is empty
+
+  status = LCDbusWrite(lcd, lcd->_txBuffer, lcd->_txLength);
+
+  LCDcountTransaction(lcd, lcd->_txLength, status == LCD_BUS_OK);
+
+  lcd->_PCF8574_latch      = lcd->_txBuffer[lcd->_txLength - 1];
+  lcd->_PCF8574_latchValid = (status == LCD_BUS_OK);
+  lcd->_txLength           = lcd->_txStart;         //backend prefix stays in the buffer
+  lcd->_linkFault          = (status == LCD_BUS_ERROR); //driver keeps tracking wanted lcd state, LCDlinkRestore() sends it again
+
+  if (status == LCD_BUS_BUSY) LCDtrackLost(lcd);   //dropped commands were already tracked
+
+  return (status == LCD_BUS_OK);
+}
+
+/**************************************************************************/
+/*
+    LCDdelayInit()
+
+    Starts microseconds delay backend
+
+    NOTE:
+    - enables DWT cycle counter, counter is never reset because
+      debugger or other code may use it too
+    - LCD_DELAY_TIMER has to be configured & started by user with 1MHz
+      tick, e.g. HAL_TIM_Base_Start(&htim6)
+*/
+/**************************************************************************/
+void LCDdelayInit(void)
+{
+  #if !defined(LCD_HOST_STUB) && !defined(LCD_DELAY_TIMER) && defined(DWT)
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;           //enable trace & debug blocks
+  DWT->CTRL        |= DWT_CTRL_CYCCNTENA_Msk;               //enable cycle counter
+  #endif
+}
+
+/**************************************************************************/
+/*
+    LCDdelayMicroseconds()
+
+    Blocking delay, in microseconds
+
+    NOTE:
+    - see LCDtimeElapsed() for resolution of every backend
+*/
+/**************************************************************************/
+void LCDdelayMicroseconds(uint16_t delay)
+{
+  #if defined(LCD_HOST_STUB)
+  struct timespec duration = {0, (long)delay * 1000};
+
+  nanosleep(&duration, NULL);
+
+  #else
+  uint32_t start = LCDtimestamp();
+
+  while (LCDtimeElapsed(start, delay) == false);
+  #endif
+}
+
+/**************************************************************************/
+/*
+    LCDtimestamp()
+
+    Returns current time stamp of delay backend
+
+    NOTE:
+    - units depend on backend, use LCDtimeElapsed() to compare:
+      - DWT cycle counter, in CPU cycles
+      - LCD_DELAY_TIMER & LCD_HOST_STUB, in microseconds
+      - HAL tick, in milliseconds
+*/
+/**************************************************************************/
+uint32_t LCDtimestamp(void)
+{
+  #if defined(LCD_HOST_STUB)
+  struct timespec now;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+
+  return (uint32_t)((now.tv_sec * 1000000) + (now.tv_nsec / 1000));
+
+  #elif defined(LCD_DELAY_TIMER)
+  return __HAL_TIM_GET_COUNTER(&LCD_DELAY_TIMER);
+
+  #elif defined(DWT)
+  return DWT->CYCCNT;
+
+  #else
+  return HAL_GetTick();
+  #endif
+}
+
+/**************************************************************************/
+/*
+    LCDtimeElapsed()
+
+    Returns true if delay, in microseconds, passed since time stamp
+
+    NOTE:
+    - DWT cycle counter resolution is 1/SystemCoreClock, overflow safe
+      up to ~59sec @ 72MHz
+    - LCD_DELAY_TIMER may be 16-bit, delay must be < 65535usec
+    - HAL tick fallback is rounded up to milliseconds + 1 tick, because
+      current tick may be about to end, e.g. Cortex-M0 without DWT
+*/
+/**************************************************************************/
+bool LCDtimeElapsed(uint32_t timestamp, uint16_t delay)
+{
+  #if defined(LCD_HOST_STUB)
+  return (LCDtimestamp() - timestamp) >= delay;
+
+  #elif defined(LCD_DELAY_TIMER)
+  return (uint16_t)(LCDtimestamp() - timestamp) >= delay;
+
+  #elif defined(DWT)
+  return (LCDtimestamp() - timestamp) >= (delay * (SystemCoreClock / 1000000));
+
+  #else
+  return (LCDtimestamp() - timestamp) > ((delay + 999) / 1000);
+  #endif
+}
+
+/**************************************************************************/
+/*
+    LCDuptime()
+
+    Returns time since MCU power-up, in milliseconds
+
+    NOTE:
+    - HAL tick starts at HAL_Init(), few milliseconds after power-up,
+      so power-on wait is never shorter than needed
+    - host build returns time since host boot
+*/
+/**************************************************************************/
+uint32_t LCDuptime(void)
+{
+  #if defined(LCD_HOST_STUB)
+  struct timespec now;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+
+  return (uint32_t)((now.tv_sec * 1000) + (now.tv_nsec / 1000000));
+
+  #else
+  return HAL_GetTick();
+  #endif
+}
+
+/**************************************************************************/
+/*
+    LCDportMappingInit()
+
+    Builds lcd pins to PCF8574 ports lookup tables, called once from
+    LCDinit()
+
+    NOTE:
+    - mapping is bitwise, so value can be split into two nibbles & each
+      nibble mapped independently:
+      - _portMappingHigh[] for RS,RW,E,DB7/DB3
+      - _portMappingLow[]  for DB6/DB2,DB5/DB1,DB4/DB0,BCK_LED
+    - 2 x 16 bytes of RAM instead of 256-bytes full table
+*/
+/**************************************************************************/
+void LCDportMappingInit(LiquidCrystal_I2C *lcd)
+{
+  for (uint8_t value = 0; value < 16; value++)
+  {
+    lcd->_portMappingHigh[value] = 0;
+    lcd->_portMappingLow[value]  = 0;
+
+    for (int8_t i = 3; i >= 0; i--)
+    {
+      switch (bitRead(value, i))            //"switch case" has smaller footprint than "if else"
+      {
+        case 1:
+          lcd->_portMappingHigh[value] |= 0x01 << lcd->_LCD_TO_PCF8574[i + 4];
+          lcd->_portMappingLow[value]  |= 0x01 << lcd->_LCD_TO_PCF8574[i];
+          break;
+      }
+    }
+  }
+}
+
+/**************************************************************************/
+/*
+    LCDportMapping()
+
+    All magic of all lcd pins to ports mapping is happening here!!!
+
+    NOTE:
+    - input value formated as:
+        7  6  5  4  3   2   1   0-bit
+      - RS,RW,E,DB7,DB6,DB5,DB4,BCK_LED
+      - RS,RW,E,DB3,DB2,DB1,DB0,BCK_LED
+
+    - lcd pin to PCF8574 ports table/array formated
+        0       1   2  3   4   5  6  7
+      {BCK_LED,DB4,DB5,DB6,DB7,E,RW,RS} 
+
+    - shifts value bits to the right PCF8574 ports
+      {BCK_LED,DB4,DB5,DB6,DB7,E,RW,RS} shift-> to ports position P7..P0
+      {BCK_LED,DB4,DB5,DB6,DB7,E,RW,RS} shift-> to ports position P7..P0
+
+    - two table lookups, tables are built by LCDportMappingInit()
+    - LCD_STANDARD_BACKPACK replaces tables with constant shifts for
+      {4,5,6,16,11,12,13,14} backpack:
+        P7  P6  P5  P4  P3      P2 P1 P0
+      - DB7,DB6,DB5,DB4,BCK_LED,E, RW,RS
+*/
+/**************************************************************************/
+uint8_t LCDportMapping(LiquidCrystal_I2C *lcd, uint8_t value)
+{
+  #if defined(LCD_STANDARD_BACKPACK)
+  (void)lcd;                                //mapping is constant
+
+  return ((value << 3) & 0xF0) |            //DB7,DB6,DB5,DB4 -> P7..P4
+         ((value << 3) & 0x08) |            //BCK_LED         -> P3
+         ((value >> 3) & 0x04) |            //E               -> P2
+         ((value >> 5) & 0x02) |            //RW              -> P1
+         ((value >> 7) & 0x01);             //RS              -> P0
+  #else
+  return lcd->_portMappingHigh[value >> 4] | lcd->_portMappingLow[value & 0x0F];
+  #endif
+}
+
+/**************************************************************************/
+/*
+    writePCF8574()
+
+    Masks backlight with data & writes it to PCF8574 over I2C
+
+    NOTE:
+    - other chips get the same outputs via backend, see LCDbackend()
+    - Wire.endTransmission() returned code:
+      0 - success
+      1 - data too long to fit in transmit data16
+      2 - received NACK on transmit of address
+      3 - received NACK on transmit of data
+      4 - other error
+*/
+/**************************************************************************/
+bool writePCF8574(LiquidCrystal_I2C *lcd, uint8_t value)
+{
+  uint8_t data[4] = {lcd->_backend->prefix};
+  uint8_t length  = lcd->_backend->prefixLength;
+  bool    success = false;
+
+  /*Wire.beginTransmission(_PCF8574_address);
+	
+  Wire.send(value | _backlightValue);
+
+  if (Wire.endTransmission(true) == 0) return true;
+                                       return false;*/
+  value  |= lcd->_backlightValue;
+  length += lcd->_backend->port(lcd, value, &data[length]);
+
+  success = LCDwriteBytes(lcd, data, length);
+
+  lcd->_PCF8574_latch      = value;
+  lcd->_PCF8574_latchValid = success;
+
+  return success;
+}
+
+/**************************************************************************/
+/*
+    readPCF8574()
+
+    Reads byte* from PCF8574 over I2C
+
+    *logic values on the PCF8574 pins P0...P7
+
+    NOTE:
+    - if PCF8574 output is written low before read, the low is always
+      returned, regardless of the device state connected
+      to the I/O, see Quasi-Bidirectional I/O for more details.
+    - if PCF8574 output is written high before read, devices has fully
+      control of PCF8574 I/O.
+*/
+/**************************************************************************/
+bool readPCF8574(LiquidCrystal_I2C *lcd, uint8_t *value)
+{
+  lcd_bus_status status = LCD_BUS_OK;
+
+  if (lcd->_linkFault == true) return false;
+
+  status = LCDbusRead(lcd, value, 1);
+
+  LCDcountTransaction(lcd, 1, status == LCD_BUS_OK);
+
+  lcd->_linkFault = (status == LCD_BUS_ERROR);
+
+  if (status == LCD_BUS_BUSY) LCDtrackLost(lcd);   //e.g. 4-bit busy flag read is cut in half
+
+  return (status == LCD_BUS_OK);
+}
+
+/**************************************************************************/
+/*
+    LCDwriteBytes()
+
+    Writes bytes in one i2c transaction, backend prefix is not added
+
+    NOTE:
+    - failed transaction opens circuit breaker, see LCDlinkService()
+    - busy bus is waited for, see LCDbusWrite()
+*/
+/**************************************************************************/
+bool LCDwriteBytes(LiquidCrystal_I2C *lcd, const uint8_t *data, uint8_t length)
+{
+  lcd_bus_status status = LCD_BUS_OK;
+
+  if (lcd->_linkFault == true) return false;        //circuit breaker is open, see LCDlinkService()
+
+  status = LCDbusWrite(lcd, data, length);
+
+  LCDcountTransaction(lcd, length, status == LCD_BUS_OK);
+
+  lcd->_linkFault = (status == LCD_BUS_ERROR);      //busy bus is not a link fault, nothing was sent
+
+  if (status == LCD_BUS_BUSY) LCDtrackLost(lcd);
+
+  return (status == LCD_BUS_OK);
+}
+
+/**************************************************************************/
+/*
+    LCDtrackLost()
+
+    Forgets software copies of lcd registers & DDRAM after transaction
+    dropped on busy bus, see LCDtrackState()
+
+    NOTE:
+    - commands were tracked before they were dropped, so copies don't
+      match the lcd any more & next calls would skip needed commands
+    - next LCDsetCursor() & mode setters are always sent, framebuffer
+      is fully sent by next flush, see LCDframeSync()
+    - glyph cache uploads every glyph again, see LCDglyph()
+    - display shift can't be known, LCDmarqueeInit() has to be called
+      again
+*/
+/**************************************************************************/
+void LCDtrackLost(LiquidCrystal_I2C *lcd)
+{
+  lcd->_addressCounter     = LCD_ADDRESS_UNKNOWN;
+  lcd->_displayControlSent = LCD_MODE_UNKNOWN;
+  lcd->_displayModeSent    = LCD_MODE_UNKNOWN;
+  lcd->_frameScreenValid   = false;
+  lcd->_glyphValid         = 0;
+  lcd->_PCF8574_latchValid = false;
+}
+
+/**************************************************************************/
+/*
+    LCDbusWrite()
+
+    Blocking i2c write to display address, retries while bus is used by
+    other display or device
+
+    NOTE:
+    - LCD_BUS_BUSY is retried for LCD_BUS_BUSY_TIMEOUT, e.g. shared bus of
+      I2C_Scheduler, after that LCD_BUS_BUSY is returned
+    - only LCD_BUS_ERROR means display is not responding
+*/
+/**************************************************************************/
+lcd_bus_status LCDbusWrite(LiquidCrystal_I2C *lcd, const uint8_t *data, uint16_t length)
+{
+  lcd_bus_status status = lcd->_bus->write(lcd->_busHandle, lcd->_PCF8574_address, data, length);
+  uint32_t       start  = 0;
+
+  if (status != LCD_BUS_BUSY) return status;
+
+  start = lcd->_bus->timestamp();
+
+  while ((status == LCD_BUS_BUSY) && (lcd->_bus->timeElapsed(start, LCD_BUS_BUSY_TIMEOUT) == false))
+  {
+    status = lcd->_bus->write(lcd->_busHandle, lcd->_PCF8574_address, data, length);
+  }
+
+  return status;
+}
+
+/**************************************************************************/
+/*
+    LCDbusRead()
+
+    Blocking i2c read from display address, see LCDbusWrite()
+*/
+/**************************************************************************/
+lcd_bus_status LCDbusRead(LiquidCrystal_I2C *lcd, uint8_t *data, uint16_t length)
+{
+  lcd_bus_status status = lcd->_bus->read(lcd->_busHandle, lcd->_PCF8574_address, data, length);
+  uint32_t       start  = 0;
+
+  if (status != LCD_BUS_BUSY) return status;
+
+  start = lcd->_bus->timestamp();
+
+  while ((status == LCD_BUS_BUSY) && (lcd->_bus->timeElapsed(start, LCD_BUS_BUSY_TIMEOUT) == false))
+  {
+    status = lcd->_bus->read(lcd->_busHandle, lcd->_PCF8574_address, data, length);
+  }
+
+  return status;
+}
+
+/**************************************************************************/
+/*
+    LCDprobe()
+
+    Sets up interface chip & all its outputs low, returns false if chip
+    is not responding
+*/
+/**************************************************************************/
+bool LCDprobe(LiquidCrystal_I2C *lcd)
+{
+  if ((lcd->_backend->setup != NULL) && (lcd->_backend->setup(lcd) == false)) return false;
+
+  return writePCF8574(lcd, PCF8574_ALL_LOW);
+}
+
+/**************************************************************************/
+/*
+    LCDportPCF8574()
+
+    PCF8574 & MCP23008 outputs, one byte, see writePCF8574()
+*/
+/**************************************************************************/
+uint8_t LCDportPCF8574(LiquidCrystal_I2C *lcd, uint8_t value, uint8_t *buffer)
+{
+  (void)lcd;
+
+  buffer[0] = value;
+
+  return 1;
+}
+
+/**************************************************************************/
+/*
+    LCDportMCP23017()
+
+    MCP23017 outputs, DB7..DB0 low & PCF8574 formated value on port A
+*/
+/**************************************************************************/
+uint8_t LCDportMCP23017(LiquidCrystal_I2C *lcd, uint8_t value, uint8_t *buffer)
+{
+  (void)lcd;
+
+  buffer[0] = PCF8574_ALL_LOW;                      //GPIOB
+  buffer[1] = value;                                //GPIOA
+
+  return 2;
+}
+
+/**************************************************************************/
+/*
+    LCDportNative()
+
+    Native controllers have no outputs, control byte without command is
+    used as probe
+*/
+/**************************************************************************/
+uint8_t LCDportNative(LiquidCrystal_I2C *lcd, uint8_t value, uint8_t *buffer)
+{
+  (void)lcd;
+  (void)value;
+
+  buffer[0] = LCD_NATIVE_IDLE;
+
+  return 1;
+}
+
+/**************************************************************************/
+/*
+    LCDsetupMCP23008()
+
+    Sets byte mode & all ports as outputs
+
+    NOTE:
+    - called on every probe, MCP23008 forgets setup after power loss,
+      see LCDlinkService()
+*/
+/**************************************************************************/
+bool LCDsetupMCP23008(LiquidCrystal_I2C *lcd)
+{
+  const uint8_t iocon[2] = {MCP23008_IOCON, MCP230XX_IOCON_SEQOP};
+  const uint8_t iodir[2] = {MCP23008_IODIR, 0x00};             //all outputs
+
+  return (LCDwriteBytes(lcd, iocon, 2) == true) && (LCDwriteBytes(lcd, iodir, 2) == true);
+}
+
+/**************************************************************************/
+/*
+    LCDsetupMCP23017()
+
+    Sets byte mode & both ports as outputs, see LCDsetupMCP23008()
+*/
+/**************************************************************************/
+bool LCDsetupMCP23017(LiquidCrystal_I2C *lcd)
+{
+  const uint8_t iocon[2] = {MCP23017_IOCON, MCP230XX_IOCON_SEQOP}; //IOCON.BANK=0 after power-up
+  const uint8_t iodir[3] = {MCP23017_IODIRA, 0x00, 0x00};         //IODIRA, IODIRB
+
+  return (LCDwriteBytes(lcd, iocon, 2) == true) && (LCDwriteBytes(lcd, iodir, 3) == true);
+}
+
+/**************************************************************************/
+/*
+    LCDextensionST7032()
+
+    Powers up ST7032 booster & voltage follower & sets contrast
+
+    NOTE:
+    - sent after soft reset in batch, extended instructions need IS=1,
+      LCDconfigurationStart() sets IS=0 again
+    - voltage follower needs ~200ms before display is turned on, caller
+      waits LCD_ST7032_FOLLOWER_DELAY, see extensionDelay of backend
+*/
+/**************************************************************************/
+void LCDextensionST7032(LiquidCrystal_I2C *lcd)
+{
+  uint8_t lines = (lcd->_lcd_rows > 1) ? LCD_2_LINE : 0;
+
+  LCDsend(lcd, LCD_INSTRUCTION_WRITE, LCD_FUNCTION_SET | LCD_8BIT_MODE | lines | ST7032_INSTRUCTION_TABLE, LCD_CMD_LENGTH_8BIT);
+  LCDsend(lcd, LCD_INSTRUCTION_WRITE, ST7032_OSC_FREQUENCY,                                                 LCD_CMD_LENGTH_8BIT);
+  LCDsend(lcd, LCD_INSTRUCTION_WRITE, ST7032_CONTRAST_LOW  | (LCD_ST7032_CONTRAST & 0x0F),                  LCD_CMD_LENGTH_8BIT);
+  LCDsend(lcd, LCD_INSTRUCTION_WRITE, ST7032_POWER_BOOSTER | ((LCD_ST7032_CONTRAST >> 4) & 0x03),           LCD_CMD_LENGTH_8BIT);
+  LCDsend(lcd, LCD_INSTRUCTION_WRITE, ST7032_FOLLOWER,                                                      LCD_CMD_LENGTH_8BIT);
+}
+
+/**************************************************************************/
+/*
+    LCDreadAddressCounter()
+
+    Reads busy flag (BF) & contents of address counter (AC)
+
+    NOTE:
+    - set RS=0 & RW=1 to retrive busy flag & address counter
+    - set PCF8574 input pins to HIGH, see Quasi-Bidirectional I/O
+    - lcd drives DB7..DB4 only while E=1, so each nibble is read
+      between E=1 & E=0 writes
+    - output value formated as BF,AC6,AC5,AC4,AC3,AC2,AC1,AC0
+    - input value formated as:
+        7  6  5  4  3   2   1   0-bit
+      - RS,RW,E,DB7,DB6,DB5,DB4,BCK_LED
+      - RS,RW,E,DB3,DB2,DB1,DB0,BCK_LED
+    - returns false if i2c transaction fails
+*/
+/**************************************************************************/
+bool LCDreadAddressCounter(LiquidCrystal_I2C *lcd, uint8_t *value)
+{
+  uint8_t data      = 0;
+  uint8_t result    = 0;
+  uint8_t nibble[2] = {0};
+
+  if (lcd->_backend->readable == false) return false;                  //e.g. native controllers are write only
+
+  LCDflushTxBuffer(lcd);                                               //safety check, buffered commands must be executed before read
+
+  data = LCDportMapping(lcd, LCD_BUSY_FLAG_READ | PCF8574_DATA_HIGH);     //RS=0,RW=1,E=1,DB7=1,DB6=1,DB5=1,DB4=1,BCK_LED=0
+
+  for (uint8_t i = 0; i < 2; i++)
+  {
+    if (writePCF8574(lcd, data)                              == false) return false; //E=1, lcd outputs nibble
+    if (readPCF8574(lcd, &nibble[i])                         == false) return false; //read RS,RW,E,DB7/DB3,DB6/DB2,DB5/DB1,DB4/DB0,BCK_LED
+    if (writePCF8574(lcd, data & ~(1 << lcd->_LCD_TO_PCF8574[5])) == false) return false; //E=0
+  }
+
+  for (int8_t i = 4; i >= 1; i--)
+  {
+    bitWrite(result, (3 + i), bitRead(nibble[0], lcd->_LCD_TO_PCF8574[i])); //BF,AC6,AC5,AC4,xx,xx,xx,xx
+    bitWrite(result, (i - 1), bitRead(nibble[1], lcd->_LCD_TO_PCF8574[i])); //BF,AC6,AC5,AC4,AC3,AC2,AC1,AC0
+  }
+
+  *value = result;
+
+  return true;
+}
+
+/**************************************************************************/
+/*
+    readBusyFlag()
+
+    Reads busy flag (BF)
+
+    NOTE:
+    - DB7 = 1, lcd busy
+      DB7 = 0, lcd ready
+    - returns true/busy if i2c transaction fails
+*/
+/**************************************************************************/
+bool LCDreadBusyFlag(LiquidCrystal_I2C *lcd)
+{
+  uint8_t data = 0;
+
+  if (LCDreadAddressCounter(lcd, &data) == false) return true;
+
+  return bitRead(data, 7);
+}
+
+/**************************************************************************/
+/*
+    LCDgetCursorPosition()
+
+    Returns contents of address counter
+
+    NOTE:
+    - address counter content DB6,DB5,DB4,DB3,DB2,DB1,DB0 
+    - resyncs software copy of address counter, see LCDtrackState()
+*/
+/**************************************************************************/
+uint8_t LCDgetCursorPosition(LiquidCrystal_I2C *lcd)
+{
+  uint8_t position = 0;
+
+  if (LCDreadAddressCounter(lcd, &position) == false) return 0;
+
+  position &= 0x7F;
+
+  if (lcd->_addressCounter != LCD_ADDRESS_CGRAM) lcd->_addressCounter = position; //CGRAM address looks the same
+
+  return position;
+}
+
+/**************************************************************************/
+/*
+    LCDbusyFlagPolling()
+
+    Waits for busy flag (BF) instead of worst case fixed delay
+
+    NOTE:
+    - RW pin has to be connected to PCF8574
+    - only delays >= LCD_BUSY_FLAG_MIN_DELAY are replaced, one BF read
+      takes 4 writes & 2 reads, it is longer than 43usec command duration
+      even @ 400kHz
+    - falls back to fixed delay if read fails or lcd stays busy longer
+      than LCD_BUSY_FLAG_POLL_LIMIT reads
+*/
+/**************************************************************************/
+void LCDbusyFlagPolling(LiquidCrystal_I2C *lcd)
+{
+  lcd->_busyFlagPolling = lcd->_backend->readable;
+}
+
+/**************************************************************************/
+/*
+    LCDnoBusyFlagPolling()
+
+    Uses worst case fixed delays after commands, by default
+*/
+/**************************************************************************/
+void LCDnoBusyFlagPolling(LiquidCrystal_I2C *lcd)
+{
+  lcd->_busyFlagPolling = false;
+}
+
+/**************************************************************************/
+/*
+    LCDwaitReady()
+
+    Waits until lcd is ready for the next command
+
+    NOTE:
+    - delay is worst case command duration, in microseconds
+*/
+/**************************************************************************/
+void LCDwaitReady(LiquidCrystal_I2C *lcd, uint16_t delay)
+{
+  uint8_t data = 0;
+
+  if (lcd->_linkFault == true) return;              //commands were not sent, see LCDflushTxBuffer()
+
+  if ((lcd->_busyFlagPolling == true) && (delay >= LCD_BUSY_FLAG_MIN_DELAY))
+  {
+    for (uint8_t i = 0; i < LCD_BUSY_FLAG_POLL_LIMIT; i++)
+    {
+      if (LCDreadAddressCounter(lcd, &data) == false) break;           //read failed, fall back to fixed delay
+      if (bitRead(data, 7)             == 0)     return;               //lcd ready
+    }
+  }
+
+  LCDdelay(lcd, delay);
+}
+
+/**************************************************************************/
+/*
+    LCDdelay()
+
+    Blocking delay of bus backend, in microseconds
+
+    NOTE:
+    - delay is counted by bus statistics, see LCDstatistics()
+*/
+/**************************************************************************/
+void LCDdelay(LiquidCrystal_I2C *lcd, uint16_t delay)
+{
+  #if defined(LCD_STATISTICS)
+  lcd->_statistics.delay += delay;
+  #endif
+
+  lcd->_bus->delay(delay);
+}
+
+/*************** !!! arduino not standard API functions !!! ***************/
+/**************************************************************************/
+/*
+    LCDprintHorizontalGraph(name, row, value, maxValue)
+
+    Prints horizontal graph
+
+    NOTE:
+    - remembers bar length of every row & sends only cells between old
+      & new length, in one i2c transaction with one cursor set, so
+      meters can be updated at hundreds of Hz
+    - row is drawn in full after LCDbegin(), LCDclear() or name change,
+      call LCDgraphReset() if graph row was overwritten by other text
+    - text direction has to be left to right, see LCDleftToRight()
+*/
+/**************************************************************************/
+void LCDprintHorizontalGraph(LiquidCrystal_I2C *lcd, char name, uint8_t row, uint16_t currentValue, uint16_t maxValue)
+{
+  uint8_t currentGraph = 0;
+  uint8_t colum        = 0;
+  uint8_t lastColum    = 0;
+  bool    batch        = lcd->_txBatch;
+
+  if (row >= lcd->_lcd_rows) row = (lcd->_lcd_rows - 1);        //safety check, same as LCDsetCursor()
+
+  if (currentValue > maxValue) currentValue = maxValue;          //safety check, to prevent ESP8266 crash
+
+  if (maxValue == 0) maxValue = 1;                              //safety check, to prevent division by zero
+
+  currentGraph = ((uint32_t)currentValue * lcd->_lcd_colums) / maxValue; //same as map(currentValue, 0, maxValue, 0, colums)
+
+  if (currentGraph < 1) currentGraph = 1;                        //colum 0 is the name, bar starts at colum 1
+
+  if ((lcd->_graphLength[row] == LCD_GRAPH_UNKNOWN) || (lcd->_graphName[row] != name))
+  {
+    colum     = 0;                                               //draw the whole row
+    lastColum = lcd->_lcd_colums;
+  }
+  else
+  {
+    if (currentGraph == lcd->_graphLength[row]) return;          //nothing changed
+
+    colum     = (currentGraph < lcd->_graphLength[row]) ? currentGraph : lcd->_graphLength[row];
+    lastColum = (currentGraph > lcd->_graphLength[row]) ? currentGraph : lcd->_graphLength[row];
+  }
+
+  if (batch == false) LCDbeginBatch(lcd);
+
+  LCDsetCursor(lcd, colum, row);
+
+  if (colum == 0)
+  {
+    LCDwrite(lcd, name);
+    colum++;
+  }
+
+  /* draw only changed part of the bar without clearing the display, to eliminate flickering */
+  for (; colum < lastColum; colum++)
+  {
+    if (colum < currentGraph) LCDwrite(lcd, 0xFF);               //print 0xFF - built in "solid square" symbol, see p.17 & p.30 of HD44780 datasheet
+    else                      LCDwrite(lcd, 0x20);               //print 0x20 - built in "space" symbol, see p.17 & p.30 of HD44780 datasheet
+  }
+
+  if (batch == false) LCDendBatch(lcd);
+
+  lcd->_graphLength[row] = currentGraph;
+  lcd->_graphName[row]   = name;
+}
+
+/**************************************************************************/
+/*
+    LCDgraphReset()
+
+    Forgets drawn graphs, next LCDprintHorizontalGraph() draws the row
+    in full
+*/
+/**************************************************************************/
+void LCDgraphReset(LiquidCrystal_I2C *lcd)
+{
+  memset(lcd->_graphLength, LCD_GRAPH_UNKNOWN, sizeof(lcd->_graphLength));
+
+  lcd->_graphEpoch++;                                            //bars drawn before are redrawn in full, see LCDbarDraw()
+}
+
+/**************************************************************************/
+/*
+    LCDbarGlyphs()
+
+    Loads partial block glyphs of bar graph into CGRAM
+
+    NOTE:
+    - horizontal bar needs 4 glyphs (1..4 pixel colums), vertical bar
+      needs 7 glyphs (1..7 pixel rows), full cell is built in 0xFF
+    - glyphs take CGRAM addresses CGRAM_address..CGRAM_address + 3/6,
+      rest of CGRAM is free for other custom characters
+    - returns false if glyphs don't fit into CGRAM, vertical bar
+      needs 5x8 font
+    - call once after LCDbegin(), both directions at the same time
+      need 11 glyphs & don't fit
+*/
+/**************************************************************************/
+bool LCDbarGlyphs(LiquidCrystal_I2C *lcd, lcd_bar_direction direction, uint8_t CGRAM_address)
+{
+  uint8_t patterns[LCD_CGRAM_SIZE] = {0};
+  uint8_t steps                     = (direction == LCD_BAR_HORIZONTAL) ? LCD_BAR_H_STEPS : LCD_BAR_V_STEPS;
+  uint8_t CGRAM_capacity            = (lcd->_lcd_font_size == LCD_5x8DOTS) ? 8 : 4;
+  uint8_t height                    = (lcd->_lcd_font_size == LCD_5x8DOTS) ? 8 : 10;
+
+  if ((direction == LCD_BAR_VERTICAL) && (lcd->_lcd_font_size != LCD_5x8DOTS)) return false;
+  if ((CGRAM_address + steps - 1) > CGRAM_capacity)                            return false;
+
+  for (uint8_t fill = 1; fill < steps; fill++)
+  {
+    for (uint8_t i = 0; i < height; i++)
+    {
+      if (direction == LCD_BAR_HORIZONTAL) patterns[((fill - 1) * height) + i] = (0x1F << (LCD_BAR_H_STEPS - fill)) & 0x1F; //pixel colums from the left
+      else                                 patterns[((fill - 1) * height) + i] = (i >= (LCD_BAR_V_STEPS - fill)) ? 0x1F : 0x00; //pixel rows from the bottom
+    }
+  }
+
+  LCDcreateChars(lcd, CGRAM_address, steps - 1, patterns);        //one upload for all glyphs
+
+  return true;
+}
+
+/**************************************************************************/
+/*
+    LCDbarInit()
+
+    Sets position, length & direction of bar graph
+
+    NOTE:
+    - horizontal bar starts at colum, row & grows to the right
+    - vertical bar starts at colum, row & grows up, row is the bottom
+    - CGRAM_address is the same as for LCDbarGlyphs()
+    - length is cut to fit the screen
+    - first LCDbarDraw() draws the bar in full
+*/
+/**************************************************************************/
+void LCDbarInit(LiquidCrystal_I2C *lcd, lcd_bar *bar, uint8_t colum, uint8_t row, uint8_t length, lcd_bar_direction direction, uint8_t CGRAM_address)
+{
+  /* safety check, bar has to fit the screen */
+  if (row   >= lcd->_lcd_rows)   row   = (lcd->_lcd_rows   - 1);
+  if (colum >= lcd->_lcd_colums) colum = (lcd->_lcd_colums - 1);
+
+  if ((direction == LCD_BAR_HORIZONTAL) && (length > (lcd->_lcd_colums - colum))) length = lcd->_lcd_colums - colum;
+  if ((direction == LCD_BAR_VERTICAL)   && (length > (row + 1)))                   length = row + 1;
+
+  bar->colum     = colum;
+  bar->row       = row;
+  bar->length    = length;
+  bar->direction = direction;
+  bar->glyph     = CGRAM_address;
+  bar->level     = 0;
+  bar->epoch     = lcd->_graphEpoch - 1;                         //bar is not drawn yet
+}
+
+/**************************************************************************/
+/*
+    LCDbarDraw()
+
+    Draws bar graph with sub-character resolution, 5 steps per cell for
+    horizontal & 8 steps per cell for vertical bar
+
+    NOTE:
+    - only cells between old & new level are sent, value moving within
+      one cell rewrites only the boundary cell
+    - bar is drawn in full after LCDclear() & etc., see LCDgraphReset()
+*/
+/**************************************************************************/
+void LCDbarDraw(LiquidCrystal_I2C *lcd, lcd_bar *bar, uint16_t value, uint16_t maxValue)
+{
+  bool batch = lcd->_txBatch;
+
+  if (batch == false) LCDbeginBatch(lcd);
+
+  LCDbarUpdate(lcd, bar, value, maxValue);
+
+  if (batch == false) LCDendBatch(lcd);
+}
+
+/**************************************************************************/
+/*
+    LCDbarsDraw()
+
+    Draws several bar graphs in one i2c transaction, e.g. multi channel
+    audio level meter
+
+    NOTE:
+    - values[] has a value for every bar, all bars share maxValue
+*/
+/**************************************************************************/
+void LCDbarsDraw(LiquidCrystal_I2C *lcd, lcd_bar *bars, const uint16_t *values, uint8_t count, uint16_t maxValue)
+{
+  bool batch = lcd->_txBatch;
+
+  if (batch == false) LCDbeginBatch(lcd);
+
+  for (uint8_t i = 0; i < count; i++)
+  {
+    LCDbarUpdate(lcd, &bars[i], values[i], maxValue);
+  }
+
+  if (batch == false) LCDendBatch(lcd);
+}
+
+/**************************************************************************/
+/*
+    LCDbarUpdate()
+
+    Sends changed cells of bar graph, see LCDbarDraw()
+*/
+/**************************************************************************/
+void LCDbarUpdate(LiquidCrystal_I2C *lcd, lcd_bar *bar, uint16_t value, uint16_t maxValue)
+{
+  uint8_t  steps     = (bar->direction == LCD_BAR_HORIZONTAL) ? LCD_BAR_H_STEPS : LCD_BAR_V_STEPS;
+  uint16_t level     = 0;
+  uint8_t  cell      = 0;
+  uint8_t  lastCell  = 0;
+
+  if (bar->length == 0) return;
+
+  if (value > maxValue) value = maxValue;                        //safety check
+
+  if (maxValue == 0) maxValue = 1;                              //safety check, to prevent division by zero
+
+  level = ((uint32_t)value * bar->length * steps) / maxValue;
+
+  if (bar->epoch != lcd->_graphEpoch)
+  {
+    cell     = 0;                                                //draw the whole bar
+    lastCell = bar->length - 1;
+  }
+  else
+  {
+    if (level == bar->level) return;                             //nothing changed
+
+    cell     = ((level < bar->level) ? level : bar->level) / steps;
+    lastCell = (((level > bar->level) ? level : bar->level) - 1) / steps;
+  }
+
+  if (bar->direction == LCD_BAR_HORIZONTAL)
+  {
+    LCDsetCursor(lcd, bar->colum + cell, bar->row);
+
+    for (; cell <= lastCell; cell++)
+    {
+      LCDwrite(lcd, LCDbarCell(lcd, bar, level, cell));              //auto-increment, no cursor set
+    }
+  }
+  else
+  {
+    for (; cell <= lastCell; cell++)
+    {
+      LCDsetCursor(lcd, bar->colum, bar->row - cell);
+      LCDwrite(lcd, LCDbarCell(lcd, bar, level, cell));
+    }
+  }
+
+  bar->level = level;
+  bar->epoch = lcd->_graphEpoch;
+}
+
+/**************************************************************************/
+/*
+    LCDbarCell()
+
+    Returns character of bar graph cell for the level
+
+    NOTE:
+    - 0x20 - built in "space" symbol, 0xFF - built in "solid square"
+      symbol, see p.17 & p.30 of HD44780 datasheet
+    - partial glyph code depends on font, see LCDglyphCode()
+*/
+/**************************************************************************/
+uint8_t LCDbarCell(LiquidCrystal_I2C *lcd, lcd_bar *bar, uint16_t level, uint8_t cell)
+{
+  uint8_t  steps = (bar->direction == LCD_BAR_HORIZONTAL) ? LCD_BAR_H_STEPS : LCD_BAR_V_STEPS;
+  uint16_t start = (uint16_t)cell * steps;
+
+  if (level <= start)           return 0x20;
+  if (level >= (start + steps)) return 0xFF;
+
+  return LCDglyphCode(lcd, bar->glyph + (level - start) - 1);   //partial glyph, see LCDbarGlyphs()
+}
+
+/**************************************************************************/
+/*
+    LCDglyphCache()
+
+    Sets CGRAM slots managed by glyph cache & forgets cached glyphs
+
+    NOTE:
+    - whole CGRAM is managed by default, give the cache only free
+      slots if other glyphs are loaded by LCDcreateChar() or
+      LCDbarGlyphs(), e.g. LCDglyphCache(lcd, 4, 4) after
+      LCDbarGlyphs(lcd, LCD_BAR_HORIZONTAL, 0)
+    - 8 slots for 5x8 font, 4 slots for 5x10 font
+*/
+/**************************************************************************/
+void LCDglyphCache(LiquidCrystal_I2C *lcd, uint8_t CGRAM_address, uint8_t count)
+{
+  uint8_t CGRAM_capacity = (lcd->_lcd_font_size == LCD_5x8DOTS) ? 8 : 4;
+
+  /* safety check, cache has to fit into CGRAM */
+  if (CGRAM_address >= CGRAM_capacity)           CGRAM_address = CGRAM_capacity - 1;
+  if (count > (CGRAM_capacity - CGRAM_address)) count         = CGRAM_capacity - CGRAM_address;
+  if (count == 0)                                count         = 1;
+
+  lcd->_glyphFirst = CGRAM_address;
+  lcd->_glyphCount = count;
+  lcd->_glyphValid = 0;
+}
+
+/**************************************************************************/
+/*
+    LCDglyph()
+
+    Returns character code of the pattern, uploads pattern only if it
+    is not in CGRAM already
+
+    NOTE:
+    - least recently used glyph is replaced when all slots are taken,
+      cells on the screen showing replaced glyph change too
+    - uploading moves address counter to CGRAM, call LCDsetCursor()
+      before writing the returned code
+    - code is CGRAM slot for 5x8 & slot * 2 for 5x10 font, see
+      LCDglyphCode()
+    - pattern is 8 bytes for 5x8 & 10 bytes for 5x10 font
+*/
+/**************************************************************************/
+uint8_t LCDglyph(LiquidCrystal_I2C *lcd, const uint8_t *char_pattern)
+{
+  uint8_t height = (lcd->_lcd_font_size == LCD_5x8DOTS) ? 8 : 10;
+
+  for (uint8_t slot = lcd->_glyphFirst; slot < (lcd->_glyphFirst + lcd->_glyphCount); slot++)
+  {
+    if ((bitRead(lcd->_glyphValid, slot) == 1) && (memcmp(&lcd->_glyphPatterns[slot * height], char_pattern, height) == 0))
+    {
+      lcd->_glyphUsed[slot] = ++lcd->_glyphClock;                //cache hit
+
+      return LCDglyphCode(lcd, slot);
+    }
+  }
+
+  return LCDglyphLoad(lcd, LCD_GLYPH_NO_ID, char_pattern);
+}
+
+/**************************************************************************/
+/*
+    LCDglyphById()
+
+    Same as LCDglyph(), but glyph is found by application id instead of
+    pattern comparison
+
+    NOTE:
+    - pattern is only read on upload, so it can be built on demand
+    - id must be unique for every pattern & != LCD_GLYPH_NO_ID
+*/
+/**************************************************************************/
+uint8_t LCDglyphById(LiquidCrystal_I2C *lcd, uint16_t id, const uint8_t *char_pattern)
+{
+  for (uint8_t slot = lcd->_glyphFirst; slot < (lcd->_glyphFirst + lcd->_glyphCount); slot++)
+  {
+    if ((bitRead(lcd->_glyphValid, slot) == 1) && (lcd->_glyphId[slot] == id))
+    {
+      lcd->_glyphUsed[slot] = ++lcd->_glyphClock;                //cache hit
+
+      return LCDglyphCode(lcd, slot);
+    }
+  }
+
+  return LCDglyphLoad(lcd, id, char_pattern);
+}
+
+/**************************************************************************/
+/*
+    LCDglyphLoad()
+
+    Uploads glyph to free or least recently used CGRAM slot of the cache
+
+    NOTE:
+    - CGRAM bytes are sent in batch, see LCDcreateChars()
+*/
+/**************************************************************************/
+uint8_t LCDglyphLoad(LiquidCrystal_I2C *lcd, uint16_t id, const uint8_t *char_pattern)
+{
+  uint8_t height = (lcd->_lcd_font_size == LCD_5x8DOTS) ? 8 : 10;
+  uint8_t victim = lcd->_glyphFirst;
+
+  for (uint8_t slot = lcd->_glyphFirst; slot < (lcd->_glyphFirst + lcd->_glyphCount); slot++)
+  {
+    if (bitRead(lcd->_glyphValid, slot) == 0)
+    {
+      victim = slot;                                             //free slot
+      break;
+    }
+
+    if ((uint16_t)(lcd->_glyphClock - lcd->_glyphUsed[slot]) > (uint16_t)(lcd->_glyphClock - lcd->_glyphUsed[victim])) victim = slot; //older, overflow safe
+  }
+
+  memcpy(&lcd->_glyphPatterns[victim * height], char_pattern, height);
+
+  LCDcreateChar(lcd, victim, &lcd->_glyphPatterns[victim * height]);
+
+  bitSet(lcd->_glyphValid, victim);
+
+  lcd->_glyphId[victim]   = id;
+  lcd->_glyphUsed[victim] = ++lcd->_glyphClock;
+
+  return LCDglyphCode(lcd, victim);
+}
+
+/**************************************************************************/
+/*
+    LCDglyphCode()
+
+    Returns character code showing CGRAM slot
+
+    NOTE:
+    - 5x10 font selects 16-byte slot by code bits 2..1, bit 0 is don't
+      care, see Table 5 of HD44780 datasheet
+*/
+/**************************************************************************/
+uint8_t LCDglyphCode(LiquidCrystal_I2C *lcd, uint8_t slot)
+{
+  return (lcd->_lcd_font_size == LCD_5x10DOTS) ? (slot << 1) : slot;
+}
+
+/**************************************************************************/
+/*
+    LCDframeBuffer()
+
+    Redirects LCDclear(), LCDsetCursor() & LCDwrite() to RAM copy of
+    the screen, use LCDflush() to send changes to the lcd
+
+    NOTE:
+    - returns false if colums * rows > LCD_FRAMEBUFFER_SIZE
+    - lcd DDRAM content is unknown at this point, so the first
+      LCDflush() sends the whole screen
+    - framebuffer starts with current screen content cleared
+*/
+/**************************************************************************/
+bool LCDframeBuffer(LiquidCrystal_I2C *lcd)
+{
+  if ((lcd->_lcd_colums * lcd->_lcd_rows) > LCD_FRAMEBUFFER_SIZE) return false; //safety check, make sure screen fits into the framebuffer
+
+  memset(lcd->_frameBuffer, 0x20, sizeof(lcd->_frameBuffer));         //0x20 - built in "space" symbol
+
+  lcd->_frameCursor      = 0;
+  lcd->_frameScreenValid = false;
+  lcd->_frameBufferMode  = true;
+  lcd->_frameUrgent      = 0;
+  lcd->_refreshPending   = true;                                  //first LCDrefreshTask() sends the whole screen without waiting
+
+  LCDgraphReset(lcd);
+
+  return true;
+}
+
+/**************************************************************************/
+/*
+    LCDnoFrameBuffer()
+
+    Returns to direct writes to the lcd, by default
+
+    NOTE:
+    - unsent framebuffer changes are lost, call LCDflush() before
+*/
+/**************************************************************************/
+void LCDnoFrameBuffer(LiquidCrystal_I2C *lcd)
+{
+  lcd->_frameBufferMode = false;
+
+  LCDgraphReset(lcd);
+}
+
+/**************************************************************************/
+/*
+    LCDflush()
+
+    Compares framebuffer with the screen content last sent & writes only
+    changed characters to the lcd
+
+    NOTE:
+    - unchanged cells are skipped, DDRAM address is set only at the
+      start of every run of changed cells, the rest of the run uses
+      address counter auto-increment
+    - with "right to left" text direction every changed cell gets its
+      own DDRAM address
+    - all writes go out in one batch, see LCDbeginBatch()
+    - returns false if i2c transaction fails
+*/
+/**************************************************************************/
+bool LCDflush(LiquidCrystal_I2C *lcd)
+{
+  uint16_t budget = 0xFFFF;                                           //no limit
+
+  if (lcd->_frameBufferMode == false) return true;
+
+  LCDframeSync(lcd);
+  LCDbeginBatch(lcd);
+
+  LCDflushRows(lcd, 0xFF, &budget);
+
+  return LCDendBatch(lcd);
+}
+
+/**************************************************************************/
+/*
+    LCDflushBudget()
+
+    Same as LCDflush(), but stops before budget of bus bytes is
+    exceeded, the rest is sent by the next call
+
+    NOTE:
+    - changed cell costs its encoded bytes, plus DDRAM address at the
+      start of every run, e.g. 4 + 4 bytes on PCF8574, see LCDcellCost()
+    - urgent rows are sent first, see LCDframeUrgent()
+    - returns true if framebuffer is fully sent & i2c transaction is
+      successful
+*/
+/**************************************************************************/
+bool LCDflushBudget(LiquidCrystal_I2C *lcd, uint16_t budget)
+{
+  bool done = true;
+
+  if (lcd->_frameBufferMode == false) return true;
+
+  LCDframeSync(lcd);
+  LCDbeginBatch(lcd);
+
+  if (lcd->_frameUrgent != 0) done = LCDflushRows(lcd, lcd->_frameUrgent, &budget);
+  if (done == true)           done = LCDflushRows(lcd, 0xFF, &budget);
+
+  return LCDendBatch(lcd) && done;
+}
+
+/**************************************************************************/
+/*
+    LCDflushPanels()
+
+    Same as LCDflush(), but for several lcd at once
+
+    NOTE:
+    - duration of the last command of every panel is covered by transfer
+      of the next panel, only the last panel is waited for
+    - panels without framebuffer are skipped
+    - returns false if any i2c transaction fails
+*/
+/**************************************************************************/
+bool LCDflushPanels(LiquidCrystal_I2C *const *panels, uint8_t count)
+{
+  uint16_t budget  = 0;
+  bool     success = true;
+  bool     sent    = false;
+
+  for (uint8_t i = 0; i < count; i++)
+  {
+    if (panels[i]->_frameBufferMode == false) continue;
+
+    budget = 0xFFFF;                                                  //no limit
+
+    LCDframeSync(panels[i]);
+    LCDbeginBatch(panels[i]);
+
+    LCDflushRows(panels[i], 0xFF, &budget);
+
+    if (LCDflushBatch(panels[i]) == false) success = false;
+
+    sent = true;
+  }
+
+  if (sent == true) LCDdelay(panels[0], LCD_COMMAND_DELAY);           //duration of the last command
+
+  return success;
+}
+
+/**************************************************************************/
+/*
+    LCDclearPanels()
+
+    Same as LCDclear(), but for several lcd at once
+
+    NOTE:
+    - clear command is sent to all panels first, so they share one
+      clear duration wait
+    - panels with framebuffer clear RAM copy only, see LCDclear()
+*/
+/**************************************************************************/
+void LCDclearPanels(LiquidCrystal_I2C *const *panels, uint8_t count)
+{
+  bool sent = false;
+
+  for (uint8_t i = 0; i < count; i++)
+  {
+    if (panels[i]->_frameBufferMode == true)
+    {
+      LCDclear(panels[i]);
+      continue;
+    }
+
+    LCDgraphReset(panels[i]);
+
+    LCDsend(panels[i], LCD_INSTRUCTION_WRITE, LCD_CLEAR_DISPLAY, LCD_CMD_LENGTH_8BIT);
+    LCDflushTxBuffer(panels[i]);                                      //in batch mode command still in the buffer
+
+    sent = true;
+  }
+
+  if (sent == true) LCDdelay(panels[0], LCD_HOME_CLEAR_DELAY * 1000);
+}
+
+/**************************************************************************/
+/*
+    LCDflushRows()
+
+    Sends changed cells of the rows, see LCDflush()
+
+    NOTE:
+    - rows is bit per row
+    - returns false if budget ran out before all changed cells were
+      sent
+*/
+/**************************************************************************/
+bool LCDflushRows(LiquidCrystal_I2C *lcd, uint8_t rows, uint16_t *budget)
+{
+  uint8_t index   = 0;
+  uint8_t cost    = 0;
+  uint8_t address = 0;
+
+  for (uint8_t row = 0; row < lcd->_lcd_rows; row++)
+  {
+    if (bitRead(rows, row) == 0) continue;
+
+    index = row * lcd->_lcd_colums;
+
+    for (uint8_t colum = 0; colum < lcd->_lcd_colums; colum++, index++)
+    {
+      if (lcd->_frameBuffer[index] == lcd->_frameScreen[index]) continue;
+
+      address = LCDrowAddress(lcd, row, colum);
+      cost    = LCDcellCost(lcd, address, lcd->_frameBuffer[index]);
+
+      if (cost > *budget) return false;                               //rest is sent next time
+
+      *budget -= cost;
+
+      if (address != lcd->_addressCounter)                            //cursor set is skipped if address counter is already there, see LCDtrackState()
+      {
+        LCDsend(lcd, LCD_INSTRUCTION_WRITE, LCD_DDRAM_ADDR_SET | address, LCD_CMD_LENGTH_8BIT);
+      }
+
+      LCDsend(lcd, LCD_DATA_WRITE, lcd->_frameBuffer[index], LCD_CMD_LENGTH_8BIT);
+
+      lcd->_frameScreen[index] = lcd->_frameBuffer[index];
+    }
+
+    bitClear(lcd->_frameUrgent, row);                                 //row is up to date
+  }
+
+  return true;
+}
+
+/**************************************************************************/
+/*
+    LCDcellCost()
+
+    Bus bytes of one framebuffer cell, DDRAM address set included if
+    address counter is not there, see LCDflushRows()
+
+    NOTE:
+    - cell is encoded by backend into scratch buffer, so cost follows
+      interface chip, e.g. 4 bytes per character on PCF8574, 2 on
+      native controller @ 400kHz, 1 in data stream
+    - new transaction adds backend prefix, e.g. command after native
+      data stream or full tx buffer
+    - data stream state of native controller is restored, nothing is
+      sent
+*/
+/**************************************************************************/
+uint8_t LCDcellCost(LiquidCrystal_I2C *lcd, uint8_t address, uint8_t value)
+{
+  uint8_t data[4] = {0};
+  uint8_t cost    = 0;
+  uint8_t size    = 0;
+  bool    stream  = lcd->_txStream;
+
+  if (address != lcd->_addressCounter)
+  {
+    size = lcd->_backend->encode(lcd, LCD_INSTRUCTION_WRITE, LCD_DDRAM_ADDR_SET | address, LCD_CMD_LENGTH_8BIT, data);
+
+    if (size == 0)                                   //command can't follow data stream, see LCDsend()
+    {
+      lcd->_txStream = false;
+      size           = lcd->_backend->prefixLength + lcd->_backend->encode(lcd, LCD_INSTRUCTION_WRITE, LCD_DDRAM_ADDR_SET | address, LCD_CMD_LENGTH_8BIT, data);
+    }
+
+    cost = size;
+  }
+
+  cost += lcd->_backend->encode(lcd, LCD_DATA_WRITE, value, LCD_CMD_LENGTH_8BIT, data);
+
+  if ((lcd->_txLength + cost) > LCD_TX_BUFFER_SIZE) cost += lcd->_backend->prefixLength; //buffer is flushed, see LCDsend()
+
+  lcd->_txStream = stream;
+
+  return cost;
+}
+
+/**************************************************************************/
+/*
+    LCDframeUrgent()
+
+    Marks framebuffer row as urgent, it is sent before other rows & is
+    not delayed by frame period of LCDrefreshTask()
+*/
+/**************************************************************************/
+void LCDframeUrgent(LiquidCrystal_I2C *lcd, uint8_t row)
+{
+  if (row >= lcd->_lcd_rows) row = (lcd->_lcd_rows - 1);            //safety check
+
+  bitSet(lcd->_frameUrgent, row);
+}
+
+/**************************************************************************/
+/*
+    LCDrefreshRate()
+
+    Sets frame period & per call budget of LCDrefreshTask()
+
+    NOTE:
+    - period in milliseconds, 0 - frame starts on every call
+    - budget in bus bytes, sets worst case blocking time of one call,
+      e.g. 64 bytes ~1.5ms @ 400kHz & ~6ms @ 100kHz, see LCDcellCost()
+*/
+/**************************************************************************/
+void LCDrefreshRate(LiquidCrystal_I2C *lcd, uint16_t period, uint16_t budget)
+{
+  if (budget < 9) budget = 9;                                        //safety check, one cell with DDRAM address & prefix on every backend
+
+  lcd->_refreshPeriod = period;
+  lcd->_refreshBudget = budget;
+}
+
+/**************************************************************************/
+/*
+    LCDrefreshTask()
+
+    Display task, call it from main loop with current time in
+    milliseconds, e.g. LCDrefreshTask(lcd, HAL_GetTick())
+
+    NOTE:
+    - application writes only to framebuffer, see LCDframeBuffer()
+    - new frame starts once per frame period, large updates are spread
+      over several calls, every call sends no more than budget
+    - urgent rows are sent on every call, see LCDframeUrgent()
+    - restores not responding display, see LCDlinkService()
+    - returns true if screen is up to date
+*/
+/**************************************************************************/
+bool LCDrefreshTask(LiquidCrystal_I2C *lcd, uint32_t now)
+{
+  if (LCDlinkService(lcd, now)  == false) return false; //display is not responding
+  if (lcd->_frameBufferMode     == false) return true;
+
+  if ((lcd->_refreshPending == false) && ((now - lcd->_refreshStart) >= lcd->_refreshPeriod))
+  {
+    lcd->_refreshPending = true;                                     //new frame
+    lcd->_refreshStart   = now;
+  }
+
+  if (lcd->_refreshPending == true)
+  {
+    if (LCDflushBudget(lcd, lcd->_refreshBudget) == true) lcd->_refreshPending = false;
+  }
+  else if (lcd->_frameUrgent != 0)
+  {
+    uint16_t budget = lcd->_refreshBudget;
+
+    LCDframeSync(lcd);
+    LCDbeginBatch(lcd);
+    LCDflushRows(lcd, lcd->_frameUrgent, &budget);
+    LCDendBatch(lcd);
+  }
+
+  return (lcd->_refreshPending == false) && (lcd->_frameUrgent == 0);
+}
+
+/**************************************************************************/
+/*
+    LCDframeSync()
+
+    Marks every framebuffer cell as changed if lcd DDRAM content is
+    unknown
+
+    NOTE:
+    - screen copy is filled with inverted framebuffer, so interrupted
+      flush resumes without resending cells that are already done
+*/
+/**************************************************************************/
+void LCDframeSync(LiquidCrystal_I2C *lcd)
+{
+  if (lcd->_frameScreenValid == true) return;
+
+  for (uint8_t i = 0; i < LCD_FRAMEBUFFER_SIZE; i++)
+  {
+    lcd->_frameScreen[i] = ~lcd->_frameBuffer[i];
+  }
+
+  lcd->_frameScreenValid = true;
+}
+
+/**************************************************************************/
+/*
+    LCDflushAsync()
+
+    Same as LCDflush(), but queues changed cells for DMA/IT transfer &
+    returns immediately
+
+    NOTE:
+    - returns false if async queue is full, cells that did not fit stay
+      changed, call it again later to queue the rest
+*/
+/**************************************************************************/
+bool LCDflushAsync(LiquidCrystal_I2C *lcd)
+{
+  uint8_t index = 0;
+
+  if (lcd->_frameBufferMode == false) return true;
+
+  if (lcd->_backend->framed == true) return LCDflush(lcd);           //async engine is not supported, see LCDbackend()
+
+  LCDframeSync(lcd);
+
+  for (uint8_t row = 0; row < lcd->_lcd_rows; row++)
+  {
+    for (uint8_t colum = 0; colum < lcd->_lcd_colums; colum++, index++)
+    {
+      if (lcd->_frameBuffer[index] == lcd->_frameScreen[index]) continue;
+
+      if (LCDsetCursorAsync(lcd, colum, row) == false) return false;  //skipped if address counter is already there
+
+      if (LCDsendAsync(lcd, LCD_DATA_WRITE, lcd->_frameBuffer[index], LCD_CMD_LENGTH_8BIT, 0) == false) return false;
+
+      lcd->_frameScreen[index] = lcd->_frameBuffer[index];
+    }
+  }
+
+  return true;
+}
+
+/**************************************************************************/
+/*
+    LCDwriteAsync()
+
+    Same as LCDwrite(), but queues character for DMA/IT transfer &
+    returns immediately
+
+    NOTE:
+    - returns false if async queue is full
+*/
+/**************************************************************************/
+bool LCDwriteAsync(LiquidCrystal_I2C *lcd, uint8_t value)
+{
+  return LCDsendAsync(lcd, LCD_DATA_WRITE, value, LCD_CMD_LENGTH_8BIT, 0);
+}
+
+/**************************************************************************/
+/*
+    LCDsetCursorAsync()
+
+    Same as LCDsetCursor(), but queues command for DMA/IT transfer &
+    returns immediately
+
+    NOTE:
+    - returns false if async queue is full
+*/
+/**************************************************************************/
+bool LCDsetCursorAsync(LiquidCrystal_I2C *lcd, uint8_t colum, uint8_t row)
+{
+  /* safety check, cursor position & array are zero indexed */
+  if (row   >= lcd->_lcd_rows)   row   = (lcd->_lcd_rows   - 1);
+  if (colum >= lcd->_lcd_colums) colum = (lcd->_lcd_colums - 1);
+
+  if (LCDrowAddress(lcd, row, colum) == lcd->_addressCounter) return true; //lcd is already there
+
+  return LCDsendAsync(lcd, LCD_INSTRUCTION_WRITE, LCD_DDRAM_ADDR_SET | LCDrowAddress(lcd, row, colum), LCD_CMD_LENGTH_8BIT, 0);
+}
+
+/**************************************************************************/
+/*
+    LCDclearAsync()
+
+    Same as LCDclear(), but queues command for DMA/IT transfer &
+    returns immediately
+
+    NOTE:
+    - command duration is timed by LCDasyncService()
+    - returns false if async queue is full
+*/
+/**************************************************************************/
+bool LCDclearAsync(LiquidCrystal_I2C *lcd)
+{
+  LCDgraphReset(lcd);
+
+  return LCDsendAsync(lcd, LCD_INSTRUCTION_WRITE, LCD_CLEAR_DISPLAY, LCD_CMD_LENGTH_8BIT, LCD_HOME_CLEAR_DELAY * 1000);
+}
+
+/**************************************************************************/
+/*
+    LCDasyncCallback()
+
+    Sets function called when async queue becomes empty
+
+    NOTE:
+    - callback is called from i2c interrupt or LCDasyncService()
+    - NULL disables callback
+*/
+/**************************************************************************/
+void LCDasyncCallback(LiquidCrystal_I2C *lcd, void (*callback)(LiquidCrystal_I2C *lcd))
+{
+  lcd->_asyncCallback = callback;
+}
+
+/**************************************************************************/
+/*
+    LCDasyncBusy()
+
+    Returns true if async queue is not empty or transfer is in progress
+*/
+/**************************************************************************/
+bool LCDasyncBusy(LiquidCrystal_I2C *lcd)
+{
+  return (lcd->_asyncState != LCD_ASYNC_IDLE) || (lcd->_asyncSegmentHead != lcd->_asyncSegmentTail);
+}
+
+/**************************************************************************/
+/*
+    LCDasyncService()
+
+    Ends command delays & starts the next transfer
+
+    NOTE:
+    - call it from main loop or from periodic timer interrupt, period
+      sets resolution of clear/home delays, e.g. 100usec..1msec
+    - also retries transfer that could not start because the bus was
+      busy with other display or device
+*/
+/**************************************************************************/
+void LCDasyncService(LiquidCrystal_I2C *lcd)
+{
+  if (lcd->_asyncState == LCD_ASYNC_TRANSFER) return;
+
+  if (lcd->_asyncState == LCD_ASYNC_DELAY)
+  {
+    if (lcd->_bus->timeElapsed(lcd->_asyncDelayStart, lcd->_asyncDelay) == false) return;
+
+    lcd->_asyncState = LCD_ASYNC_IDLE;
+
+    if ((LCDasyncStart(lcd) == false) && (lcd->_asyncCallback != NULL)) lcd->_asyncCallback(lcd); //queue is empty
+    return;
+  }
+
+  LCDasyncStart(lcd);
+}
+
+/**************************************************************************/
+/*
+    LCDasyncTxComplete()
+
+    Moves async queue forward, call it from HAL_I2C_MasterTxCpltCallback()
+    for every display
+
+    NOTE:
+    - transfers of other i2c handles are ignored
+    - display waiting for the bus shared with other display starts its
+      transfer here, as soon as the bus is free
+    - segment wrapped around the end of the buffer is sent in two
+      transfers
+*/
+/**************************************************************************/
+void LCDasyncTxComplete(LiquidCrystal_I2C *lcd, void *handle)
+{
+  lcd_async_segment *segment = &lcd->_asyncSegments[lcd->_asyncSegmentTail];
+
+  if (handle != lcd->_busHandle) return;
+
+  if (lcd->_asyncState != LCD_ASYNC_TRANSFER)
+  {
+    if (lcd->_asyncState == LCD_ASYNC_IDLE) LCDasyncStart(lcd);    //bus is free now
+    return;
+  }
+
+  lcd->_asyncTail  = (lcd->_asyncTail + lcd->_asyncChunk) & (LCD_ASYNC_BUFFER_SIZE - 1);
+  segment->length -= lcd->_asyncChunk;
+
+  if (segment->length == 0)
+  {
+    lcd->_asyncDelay       = segment->delay;
+    lcd->_asyncSegmentTail = (lcd->_asyncSegmentTail + 1) & (LCD_ASYNC_SEGMENTS - 1);
+
+    if (lcd->_asyncDelay != 0)
+    {
+      #if defined(LCD_STATISTICS)
+      lcd->_statistics.delay += lcd->_asyncDelay;
+      #endif
+
+      lcd->_asyncDelayStart = lcd->_bus->timestamp();
+      lcd->_asyncState      = LCD_ASYNC_DELAY;                        //LCDasyncService() continues after delay
+
+      return;
+    }
+  }
+
+  lcd->_asyncState = LCD_ASYNC_IDLE;
+
+  if ((LCDasyncStart(lcd) == false) && (lcd->_asyncCallback != NULL)) lcd->_asyncCallback(lcd); //queue is empty
+}
+
+/**************************************************************************/
+/*
+    LCDasyncError()
+
+    Drops async queue, call it from HAL_I2C_ErrorCallback() for every
+    display
+
+    NOTE:
+    - framebuffer is sent in full by the next flush, because lcd DDRAM
+      content is unknown
+*/
+/**************************************************************************/
+void LCDasyncError(LiquidCrystal_I2C *lcd, void *handle)
+{
+  if ((handle != lcd->_busHandle) || (lcd->_asyncState != LCD_ASYNC_TRANSFER)) return;
+
+  #if defined(LCD_STATISTICS)
+  lcd->_statistics.errors++;                                       //transaction is counted by LCDasyncStart()
+  #endif
+
+  LCDasyncDrop(lcd);
+}
+
+/**************************************************************************/
+/*
+    LCDasyncDrop()
+
+    Empties async queue
+*/
+/**************************************************************************/
+void LCDasyncDrop(LiquidCrystal_I2C *lcd)
+{
+  LCD_ENTER_CRITICAL();
 
-    - duration of command > 43usec for GDM2004D
-    - duration of the En pulse > 450nsec
+  lcd->_asyncTail        = lcd->_asyncHead;
+  lcd->_asyncSegmentTail = lcd->_asyncSegmentHead;
+  lcd->_asyncState       = LCD_ASYNC_IDLE;
+
+  lcd->_PCF8574_latchValid = false;
+  lcd->_linkFault          = true;                   //dropped commands were already tracked, LCDlinkRestore() sends them again
+
+  LCD_EXIT_CRITICAL();
+}
+
+/**************************************************************************/
+/*
+    LCDsendAsync()
+
+    Encodes COMMAND or DATA/TEXT into async queue & starts transfer if
+    bus is idle
+
+    NOTE:
+    - delay is command duration after transfer, in microseconds, 0 for
+      commands covered by i2c byte time, see LCDbeginBatch()
+    - commands without delay are appended to the last queued segment
+      if it's not in transfer, so text goes out in long DMA transfers
+    - returns false if async queue is full
 */
 /**************************************************************************/
-void LCDsend(uint8_t mode, uint8_t value, uint8_t length)
+bool LCDsendAsync(LiquidCrystal_I2C *lcd, uint8_t mode, uint8_t value, uint8_t length, uint16_t delay)
 {
-  uint8_t  halfByte = 0; //lsb or msb
-  uint8_t  data     = 0, dataBuffer[2] = {0};
+  uint8_t  data[4] = {0};
+  uint8_t  size    = 0;
+  uint16_t head    = lcd->_asyncHead;
+  uint8_t  last    = 0;
+  bool     queued  = false;
 
-  /* 4-bit or 1-st part of 8-bit command */
-  halfByte  = value >> 3;                     //0,0,0,DB7,DB6,DB5,DB4,DB3
-  halfByte &= 0x1E;                           //0,0,0,DB7,DB6,DB5,DB4,BCK_LED=0
-  data      = portMapping(mode | halfByte);   //RS,RW,E=1,DB7,DB6,DB5,DB4,BCK_LED=0
+  if (lcd->_linkFault       == true) return false;                //circuit breaker is open, see LCDlinkService()
+  if (lcd->_backend->framed == true) return false;                //queue is split at buffer end, see LCDasyncStart()
 
-  writePCF8574(data);                         //send command
-                                              //En pulse duration > 450nsec
-  bitClear(data, _LCD_TO_PCF8574[5]);         //RS,RW,E=0,DB7,DB6,DB5,DB4,BCK_LED=0
-  writePCF8574(data);                         //execute command
-  //delayMicroseconds(LCD_COMMAND_DELAY);       //command duration
-  HAL_Delay(1);
+  size = lcd->_backend->encode(lcd, mode, value, length, data);
 
-  /* second part of 8-bit command */
-  if (length == LCD_CMD_LENGTH_8BIT)
+  if (((LCD_ASYNC_BUFFER_SIZE - 1) - ((head - lcd->_asyncTail) & (LCD_ASYNC_BUFFER_SIZE - 1))) < size) return false; //safety check, make sure command fits into the buffer
+
+  for (uint8_t i = 0; i < size; i++)
   {
-    halfByte  = value << 1;                   //DB6,DB5,DB4,DB3,DB2,DB1,DB0,0
-    halfByte &= 0x1E;                         //0,0,0,DB3,DB2,DB1,DB0,BCK_LED=0
-    data      = portMapping(mode | halfByte); //RS,RW,E=1,DB3,DB2,DB1,DB0,BCK_LED=0
+    lcd->_asyncBuffer[head] = data[i];
+    head                    = (head + 1) & (LCD_ASYNC_BUFFER_SIZE - 1);
+  }
 
-    writePCF8574(data);                       //send command
-                                              //En pulse duration > 450nsec
-    bitClear(data, _LCD_TO_PCF8574[5]);       //RS,RW,E=0,DB3,DB2,DB1,DB0,BCK_LED=0
-    writePCF8574(data);                       //execute command
-    //delayMicroseconds(LCD_COMMAND_DELAY);     //command duration
-    HAL_Delay(1);
+  LCD_ENTER_CRITICAL();
+
+  last = (lcd->_asyncSegmentHead - 1) & (LCD_ASYNC_SEGMENTS - 1);
+
+  /* append to the last segment if it's queued, not in transfer & has no delay */
+  if ((lcd->_asyncSegmentHead != lcd->_asyncSegmentTail) && (lcd->_asyncSegments[last].delay == 0) &&
+      !((last == lcd->_asyncSegmentTail) && (lcd->_asyncState == LCD_ASYNC_TRANSFER)))
+  {
+    lcd->_asyncSegments[last].length += size;
+    lcd->_asyncSegments[last].delay   = delay;
+    queued                            = true;
+  }
+  else if (((lcd->_asyncSegmentHead + 1) & (LCD_ASYNC_SEGMENTS - 1)) != lcd->_asyncSegmentTail)
+  {
+    lcd->_asyncSegments[lcd->_asyncSegmentHead].length = size;
+    lcd->_asyncSegments[lcd->_asyncSegmentHead].delay  = delay;
+    lcd->_asyncSegmentHead                             = (lcd->_asyncSegmentHead + 1) & (LCD_ASYNC_SEGMENTS - 1);
+    queued                                             = true;
   }
+
+  if (queued == true) lcd->_asyncHead = head;                      //publish encoded bytes
+
+  LCD_EXIT_CRITICAL();
+
+  if (queued == false) return false;                               //segments queue is full
+
+  LCDtrackState(lcd, mode, value, length);                       //queue is executed in order
+
+  lcd->_PCF8574_latch      = data[size - 1];                       //PCF8574 outputs after queue is sent
+  lcd->_PCF8574_latchValid = true;
+
+  LCDasyncStart(lcd);
+
+  return true;
 }
 
 /**************************************************************************/
 /*
-    LCDportMapping()
+    LCDasyncStart()
 
-    All magic of all lcd pins to ports mapping is happening here!!!
+    Starts DMA/IT transfer of the next queued segment if bus is idle
 
     NOTE:
-    - input value formated as:
-        7  6  5  4  3   2   1   0-bit
-      - RS,RW,E,DB7,DB6,DB5,DB4,BCK_LED
-      - RS,RW,E,DB3,DB2,DB1,DB0,BCK_LED
-
-    - lcd pin to PCF8574 ports table/array formated
-        0       1   2  3   4   5  6  7
-      {BCK_LED,DB4,DB5,DB6,DB7,E,RW,RS} 
-
-    - shifts value bits to the right PCF8574 ports
-      {BCK_LED,DB4,DB5,DB6,DB7,E,RW,RS} shift-> to ports position P7..P0
-      {BCK_LED,DB4,DB5,DB6,DB7,E,RW,RS} shift-> to ports position P7..P0
-
-    - "switch case" is 32us faster than
-      bitWrite(data, _LCD_TO_PCF8574[i], bitRead(value, i));
+    - DMA needs continuous memory, so transfer stops at the end of the
+      ring buffer
+    - if the bus is busy with other display or device, transfer stays
+      queued until LCDasyncService() or LCDasyncTxComplete()
+    - define LCD_ASYNC_IT to use interrupt transfers instead of DMA
+    - returns false if queue is empty
 */
 /**************************************************************************/
-uint8_t LCDportMapping(uint8_t value)
+bool LCDasyncStart(LiquidCrystal_I2C *lcd)
 {
-  uint8_t data = 0;
+  lcd_bus_status status = LCD_BUS_OK;
+  uint16_t       chunk  = 0;
+
+  LCD_ENTER_CRITICAL();
 
-  /* mapping value = RS,RW,E,DB7,DB6,DB5,DB4,BCK_LED */
-  for (int8_t i = 7; i >= 0; i--)
+  if (lcd->_asyncSegmentHead == lcd->_asyncSegmentTail)
   {
-    switch (bitRead(value, i))              //"switch case" has smaller footprint than "if else"
-    {
-      case 1:
-        data |= 0x01 << _LCD_TO_PCF8574[i];
-        break;
-    }
+    LCD_EXIT_CRITICAL();
+    return false;
+  }
+
+  if (lcd->_asyncState != LCD_ASYNC_IDLE)
+  {
+    LCD_EXIT_CRITICAL();
+    return true;                                                   //transfer or delay in progress
+  }
+
+  chunk = lcd->_asyncSegments[lcd->_asyncSegmentTail].length;
+
+  if (chunk > (LCD_ASYNC_BUFFER_SIZE - lcd->_asyncTail)) chunk = LCD_ASYNC_BUFFER_SIZE - lcd->_asyncTail;
+
+  lcd->_asyncChunk = chunk;
+  lcd->_asyncState = LCD_ASYNC_TRANSFER;
+
+  LCD_EXIT_CRITICAL();
+
+  if (lcd->_bus->writeAsync == NULL)
+  {
+    status = lcd->_bus->write(lcd->_busHandle, lcd->_PCF8574_address, &lcd->_asyncBuffer[lcd->_asyncTail], chunk);
+
+    if (status == LCD_BUS_OK) LCDasyncTxComplete(lcd, lcd->_busHandle); //blocking write is already complete
+  }
+  else
+  {
+    status = lcd->_bus->writeAsync(lcd->_busHandle, lcd->_PCF8574_address, &lcd->_asyncBuffer[lcd->_asyncTail], chunk);
+  }
+
+  switch (status)
+  {
+    case LCD_BUS_OK:
+      LCDcountTransaction(lcd, chunk, true);
+      break;
+
+    case LCD_BUS_BUSY:
+      lcd->_asyncState = LCD_ASYNC_IDLE;                           //bus is used by other display or device, try later
+      break;
+
+    default:
+      LCDcountTransaction(lcd, chunk, false);
+      LCDasyncDrop(lcd);
+      break;
   }
 
-  return data; 
+  return true;
 }
 
 /**************************************************************************/
 /*
-    writePCF8574()
+    LCDcountTransaction()
 
-    Masks backlight with data & writes it to PCF8574 over I2C
+    Adds i2c transaction to bus statistics, see LCDstatistics()
+*/
+/**************************************************************************/
+void LCDcountTransaction(LiquidCrystal_I2C *lcd, uint16_t length, bool success)
+{
+  #if defined(LCD_STATISTICS)
+  lcd->_statistics.transactions++;
+  lcd->_statistics.bytes += length;
+
+  if (success == false) lcd->_statistics.errors++;
+  #else
+  (void)lcd;
+  (void)length;
+  (void)success;
+  #endif
+}
+
+/**************************************************************************/
+/*
+    LCDstatistics()
+
+    Copies bus statistics of the display since LCDinit() or
+    LCDresetStatistics()
 
     NOTE:
-    - Wire.endTransmission() returned code:
-      0 - success
-      1 - data too long to fit in transmit data16
-      2 - received NACK on transmit of address
-      3 - received NACK on transmit of data
-      4 - other error
+    - define LCD_STATISTICS, otherwise all counters are zero
+    - wrap any API call with LCDresetStatistics() & LCDstatistics() to
+      get its i2c cost, e.g. LCDclear() = 1 transaction, 4 bytes, 2043usec
+    - async transfers are counted when they start, delays when they
+      begin
 */
 /**************************************************************************/
-bool writePCF8574(uint8_t value)
+void LCDstatistics(LiquidCrystal_I2C *lcd, lcd_statistics *stats)
 {
-  /*Wire.beginTransmission(_PCF8574_address);
-	
-  Wire.send(value | _backlightValue);
+  #if defined(LCD_STATISTICS)
+  LCD_ENTER_CRITICAL();
 
-  if (Wire.endTransmission(true) == 0) return true;
-                                       return false;*/
-  value |= _backlightValue;
-  if( HAL_I2C_Master_Transmit(&hi2c1, _PCF8574_address,(uint8_t *) &value, 1, 100) != HAL_OK) return false;
-	
-  return true;
+  *stats = lcd->_statistics;
+
+  LCD_EXIT_CRITICAL();
+  #else
+  (void)lcd;
+
+  memset(stats, 0, sizeof(lcd_statistics));
+  #endif
 }
 
 /**************************************************************************/
 /*
-    readPCF8574()
+    LCDresetStatistics()
 
-    Reads byte* from PCF8574 over I2C
+    Sets all bus statistics counters to zero
+*/
+/**************************************************************************/
+void LCDresetStatistics(LiquidCrystal_I2C *lcd)
+{
+  #if defined(LCD_STATISTICS)
+  LCD_ENTER_CRITICAL();
 
-    *logic values on the PCF8574 pins P0...P7
+  memset(&lcd->_statistics, 0, sizeof(lcd_statistics));
+
+  LCD_EXIT_CRITICAL();
+  #else
+  (void)lcd;
+  #endif
+}
+
+/**************************************************************************/
+/*
+    LCDlinkService()
+
+    Circuit breaker service, call it from main loop with current time in
+    milliseconds, e.g. LCDlinkService(lcd, HAL_GetTick())
 
     NOTE:
-    - if PCF8574 output is written low before read, the low is always
-      returned, regardless of the device state connected
-      to the I/O, see Quasi-Bidirectional I/O for more details.
-    - if PCF8574 output is written high before read, devices has fully
-      control of PCF8574 I/O.
+    - first i2c error opens circuit breaker, after that all commands are
+      tracked but dropped without bus transactions & delays, so missing
+      display never blocks for LCD_I2C_TIMEOUT on every command
+    - display address is probed once per LCD_LINK_RETRY_PERIOD, if
+      PCF8574 responds lcd is initialized again & screen, CGRAM, modes &
+      cursor are restored, see LCDlinkRestore()
+    - initialization is spread over several calls, every step waits on
+      time stamps instead of delays, see lcd_link_step:
+      - LCD_POWER_ON_DELAY after probe, plugged lcd may be just powered
+      - LCD_RESET_DELAY after 1-st soft reset nibble
+      - backend extensionDelay, e.g. ST7032 voltage follower
+    - breaker stays open until the last step, commands of application
+      are tracked & dropped meanwhile, last step restores them too
+    - failed step starts again with probe after LCD_LINK_RETRY_PERIOD
+    - also brings up display that was not connected during LCDbegin()
+    - called by LCDrefreshTask()
+    - returns true if display is responding
 */
 /**************************************************************************/
-uint8_t readPCF8574()
+bool LCDlinkService(LiquidCrystal_I2C *lcd, uint32_t now)
 {
-  uint8_t l_Data = 0;
-	
-  if(HAL_I2C_Master_Receive(&hi2c1, _PCF8574_address,(uint8_t *) &l_Data, 1, 100) != HAL_OK) return false;
-	
-  return l_Data;
+  if (lcd->_linkFault == false) return true;
+
+  switch (lcd->_linkStep)
+  {
+    case LCD_LINK_PROBE:
+      if ((now - lcd->_linkProbeTime) < LCD_LINK_RETRY_PERIOD) return false;
+
+      lcd->_linkProbeTime = now;
+
+      LCDflushTxBuffer(lcd);                                 //drops commands tracked while display was not responding
+
+      lcd->_linkFault = false;
+
+      if (LCDprobe(lcd) == true) lcd->_linkStep  = LCD_LINK_POWER_ON;
+      else                       lcd->_linkFault = true;      //busy bus doesn't open breaker, see LCDwriteBytes()
+      break;
+
+    case LCD_LINK_POWER_ON:
+      if ((now - lcd->_linkProbeTime) <= LCD_POWER_ON_DELAY) return false; //"<=" ms tick may come right after probe
+
+      lcd->_linkProbeTime = now;
+
+      LCDflushTxBuffer(lcd);
+
+      lcd->_linkFault = false;
+
+      /* FIRST ATTEMPT: set 8-bit mode, see LCDinitializationPanels() */
+      LCDbeginBatch(lcd);
+      LCDsend(lcd, LCD_INSTRUCTION_WRITE, LCD_FUNCTION_SET | LCD_8BIT_MODE, LCD_CMD_LENGTH_4BIT);
+
+      if (LCDflushBatch(lcd) == false) lcd->_linkFault = true; //nibble is lost, e.g. bus stays busy
+
+      lcd->_linkStep = LCD_LINK_RESET;
+      break;
+
+    case LCD_LINK_RESET:
+      if ((now - lcd->_linkProbeTime) <= ((LCD_RESET_DELAY + 999) / 1000)) return false;
+
+      lcd->_linkProbeTime = now;
+
+      LCDflushTxBuffer(lcd);
+
+      lcd->_linkFault = false;
+
+      /* SECOND ATTEMPT: set 8-bit mode */
+      LCDbeginBatch(lcd);
+      LCDsend(lcd, LCD_INSTRUCTION_WRITE, LCD_FUNCTION_SET | LCD_8BIT_MODE, LCD_CMD_LENGTH_4BIT);
+      LCDflushTxBuffer(lcd);
+      LCDdelay(lcd, LCD_RESET_NIBBLE_DELAY);
+
+      LCDresetInterface(lcd);
+
+      if      (LCDendBatch(lcd)              == false) lcd->_linkFault = true;
+      else if (lcd->_backend->extensionDelay == 0)     LCDlinkConfigure(lcd);
+      else                                             lcd->_linkStep  = LCD_LINK_EXTENSION;
+      break;
+
+    case LCD_LINK_EXTENSION:
+      if ((now - lcd->_linkProbeTime) <= lcd->_backend->extensionDelay) return false;
+
+      lcd->_linkProbeTime = now;
+
+      LCDflushTxBuffer(lcd);
+
+      lcd->_linkFault = false;
+
+      LCDlinkConfigure(lcd);
+      break;
+  }
+
+  if      (lcd->_linkFault == true)           lcd->_linkStep  = LCD_LINK_PROBE; //not responding or bus is busy, start again after retry period
+  else if (lcd->_linkStep  != LCD_LINK_PROBE) lcd->_linkFault = true;           //restore is not finished, application commands are still dropped
+
+  return (lcd->_linkFault == false);
 }
 
 /**************************************************************************/
 /*
-    readBusyFlag()
+    LCDlinkConfigure()
 
-    Reads busy flag (BF)
+    Last step of link restore, sets lcd modes & clears it, then sends
+    wanted lcd state, see LCDlinkService()
 
     NOTE:
-    - set RS=0 & RW=1 to retrive busy flag
-    - set PCF8574 input pins to HIGH, see Quasi-Bidirectional I/O
-    - DB7 = 1, lcd busy
-      DB7 = 0, lcd ready
-    - input value formated as:
-        7  6  5  4  3   2   1   0-bit
-      - RS,RW,E,DB7,DB6,DB5,DB4,BCK_LED
-      - RS,RW,E,DB3,DB2,DB1,DB0,BCK_LED
+    - called with closed breaker after soft reset & extension waits
+    - wanted state is saved right before clear, so commands dropped
+      during earlier steps are restored too
 */
 /**************************************************************************/
-bool LCDreadBusyFlag()
+void LCDlinkConfigure(LiquidCrystal_I2C *lcd)
 {
-  LCDsend(LCD_BUSY_FLAG_READ, PCF8574_DATA_HIGH, LCD_CMD_LENGTH_4BIT); //set RS=0, RW=1 & input pins to HIGH, see Quasi-Bidirectional I/O
+  uint8_t screen[LCD_FRAMEBUFFER_SIZE] = {0};
+  uint8_t address                      = lcd->_addressCounter;
+  uint8_t displayControl               = lcd->_displayControl;
+  uint8_t displayMode                  = lcd->_displayMode;
+  uint8_t glyphValid                   = lcd->_glyphValid;
+  uint8_t glyphFirst                   = lcd->_glyphFirst;
+  uint8_t glyphCount                   = lcd->_glyphCount;
+
+  if ((lcd->_frameScreenValid == true) && (lcd->_frameBufferMode == false)) memcpy(screen, lcd->_frameScreen, sizeof(screen));
+  else                                                                       memset(screen, 0x20, sizeof(screen)); //framebuffer is sent by next flush
+
+  LCDbeginBatch(lcd);
+  LCDconfiguration(lcd);
+  LCDendBatch(lcd);
+
+  lcd->_displayControl = displayControl;
+  lcd->_displayMode    = displayMode;
+
+  LCDlinkRestore(lcd, screen, address);
 
-  return bitRead(readPCF8574(), _LCD_TO_PCF8574[4]);
+  lcd->_glyphValid = glyphValid;                              //CGRAM matches the copy again
+  lcd->_glyphFirst = glyphFirst;
+  lcd->_glyphCount = glyphCount;
+
+  lcd->_linkStep = LCD_LINK_PROBE;
 }
 
 /**************************************************************************/
 /*
-    LCDgetCursorPosition()
+    LCDconnected()
 
-    Returns contents of address counter
+    Returns false if circuit breaker is open, see LCDlinkService()
+*/
+/**************************************************************************/
+bool LCDconnected(LiquidCrystal_I2C *lcd)
+{
+  return (lcd->_linkFault == false);
+}
+
+/**************************************************************************/
+/*
+    LCDlinkRestore()
+
+    Sends wanted lcd state to freshly initialized display
 
     NOTE:
-    - set RS=0 & RW=1 to retrive address counter
-    - set PCF8574 input pins to HIGH, see Quasi-Bidirectional I/O
-    - address counter content DB6,DB5,DB4,DB3,DB2,DB1,DB0 
-    - input value formated as:
-        7  6  5  4  3   2   1   0-bit
-      - RS,RW,E,DB7,DB6,DB5,DB4,BCK_LED
-      - RS,RW,E,DB3,DB2,DB1,DB0,BCK_LED
+    - CGRAM is sent from _glyphPatterns[], copy of all LCDcreateChars()
+    - text is written before entry mode, so autoscroll doesn't shift it
+    - display shift is lost, LCDmarqueeInit() has to be called again
+    - in framebuffer mode _frameScreen is cleared by LCDinitialization()
+      & whole framebuffer is sent by next flush
 */
 /**************************************************************************/
-uint8_t LCDgetCursorPosition()
+void LCDlinkRestore(LiquidCrystal_I2C *lcd, const uint8_t *screen, uint8_t address)
 {
-  uint8_t data     = 0;
-  uint8_t position = 0;
+  uint8_t index = 0;
 
-  LCDsend(LCD_BUSY_FLAG_READ, PCF8574_DATA_HIGH, LCD_CMD_LENGTH_4BIT); //set RS=0, RW=1 & input pins to HIGH, see Quasi-Bidirectional I/O
+  LCDbeginBatch(lcd);
 
-  data = readPCF8574();                                             //read RS,RW,E,DB7,DB6,DB5,DB4,BCK_LED
+  LCDcreateChars(lcd, 0, 8, lcd->_glyphPatterns);             //count is clamped to CGRAM capacity
 
-  /* saving DB6,DB5,DB4 bits*/
-  for (int8_t i = 3; i >= 1; i--)
+  for (uint8_t row = 0; row < lcd->_lcd_rows; row++)
   {
-    bitWrite(position, (3 + i), bitRead(data, _LCD_TO_PCF8574[i])); //xx,DB6,DB5,DB4,DB3,DB2,DB1,DB0
-  }
+    for (uint8_t colum = 0; colum < lcd->_lcd_colums; colum++)
+    {
+      index = (row * lcd->_lcd_colums) + colum;
 
-  LCDsend(LCD_BUSY_FLAG_READ, PCF8574_DATA_HIGH, LCD_CMD_LENGTH_4BIT); //set RS=0, RW=1 & input pins to HIGH, see Quasi-Bidirectional I/O
+      if (screen[index] == 0x20) continue;                     //DDRAM is already cleared
 
-  data = readPCF8574();                                             //read RS,RW,E,DB3,DB2,DB1,DB0,BCK_LED
+      if (LCDrowAddress(lcd, row, colum) != lcd->_addressCounter) LCDsend(lcd, LCD_INSTRUCTION_WRITE, LCD_DDRAM_ADDR_SET | LCDrowAddress(lcd, row, colum), LCD_CMD_LENGTH_8BIT);
 
-  /* saving DB3,DB2,DB1,DB0 bits */
-  for (int8_t i = 4; i >= 1; i--)
-  {
-    bitWrite(position, (i - 1), bitRead(data, _LCD_TO_PCF8574[i])); //xx,DB6,DB5,DB4,DB3,DB2,DB1,DB0
+      LCDsend(lcd, LCD_DATA_WRITE, screen[index], LCD_CMD_LENGTH_8BIT);
+    }
   }
 
-  return position;
+  LCDupdateModes(lcd);
+
+  if (address < LCD_ADDRESS_CGRAM) LCDsend(lcd, LCD_INSTRUCTION_WRITE, LCD_DDRAM_ADDR_SET | address, LCD_CMD_LENGTH_8BIT); //cursor, CGRAM address is left by LCDcreateChars()
+
+  LCDendBatch(lcd);
 }
 
-/*************** !!! arduino not standard API functions !!! ***************/
+#if !defined(LCD_HOST_STUB)
 /**************************************************************************/
 /*
-    LCDprintHorizontalGraph(name, row, value, maxValue)
+    LCDhalWrite()
 
-    Prints horizontal graph
+    STM32 HAL blocking i2c write, see LCDbusHAL
+
+    NOTE:
+    - handle is I2C_HandleTypeDef, HAL needs address shifted to 8-bit
 */
 /**************************************************************************/
-void LCDprintHorizontalGraph(char name, uint8_t row, uint16_t currentValue, uint16_t maxValue)
+lcd_bus_status LCDhalWrite(void *handle, uint8_t address, const uint8_t *data, uint16_t length)
 {
-  uint8_t currentGraph = 0;
-  uint8_t colum        = 0;
+  return LCDhalStatus(HAL_I2C_Master_Transmit((I2C_HandleTypeDef *)handle, (address << 1), (uint8_t *)data, length, LCD_I2C_TIMEOUT));
+}
 
-  if (currentValue > maxValue) currentValue = maxValue;          //safety check, to prevent ESP8266 crash
+/**************************************************************************/
+/*
+    LCDhalRead()
+
+    STM32 HAL blocking i2c read, see LCDbusHAL
+*/
+/**************************************************************************/
+lcd_bus_status LCDhalRead(void *handle, uint8_t address, uint8_t *data, uint16_t length)
+{
+  return LCDhalStatus(HAL_I2C_Master_Receive((I2C_HandleTypeDef *)handle, (address << 1), data, length, LCD_I2C_TIMEOUT));
+}
 
-  currentGraph = map(currentValue, 0, maxValue, 0, _lcd_colums);
+/**************************************************************************/
+/*
+    LCDhalWriteAsync()
 
-  setCursor(colum, row);
-  send(LCD_DATA_WRITE, name, LCD_CMD_LENGTH_8BIT);
+    STM32 HAL DMA i2c write, see LCDbusHAL
 
-  /* draw the horizontal bar without clearing the display, to eliminate flickering */
-  for (colum = 1; colum < currentGraph; colum++)
-  {
-    setCursor(colum, row);
-    send(LCD_DATA_WRITE, 0xFF, LCD_CMD_LENGTH_8BIT);             //print 0xFF - built in "solid square" symbol, see p.17 & p.30 of HD44780 datasheet
-  }
+    NOTE:
+    - define LCD_ASYNC_IT to use interrupt transfers instead of DMA
+    - call LCDasyncTxComplete() from HAL_I2C_MasterTxCpltCallback()
+*/
+/**************************************************************************/
+lcd_bus_status LCDhalWriteAsync(void *handle, uint8_t address, const uint8_t *data, uint16_t length)
+{
+  #if defined(LCD_ASYNC_IT)
+  return LCDhalStatus(HAL_I2C_Master_Transmit_IT((I2C_HandleTypeDef *)handle,  (address << 1), (uint8_t *)data, length));
+  #else
+  return LCDhalStatus(HAL_I2C_Master_Transmit_DMA((I2C_HandleTypeDef *)handle, (address << 1), (uint8_t *)data, length));
+  #endif
+}
+
+/**************************************************************************/
+/*
+    LCDhalStatus()
 
-  /* fill the rest with spaces */
-  while (colum++ < _lcd_colums)
+    Converts HAL status to bus status
+*/
+/**************************************************************************/
+lcd_bus_status LCDhalStatus(HAL_StatusTypeDef status)
+{
+  switch (status)
   {
-    send(LCD_DATA_WRITE, 0x20, LCD_CMD_LENGTH_8BIT);             //print 0x20 - built in "space" symbol, see p.17 & p.30 of HD44780 datasheet
+    case HAL_OK:
+      return LCD_BUS_OK;
+
+    case HAL_BUSY:
+      return LCD_BUS_BUSY;
+
+    default:
+      return LCD_BUS_ERROR;
   }
 }
+#endif
 
 /**************************************************************************/
 /*
@@ -825,10 +4173,12 @@ void LCDprintHorizontalGraph(char name, uint8_t row, uint16_t currentValue, uint
     - text remains in DDRAM
 */
 /**************************************************************************/
-void LCDdisplayOff(void)
+void LCDdisplayOff(LiquidCrystal_I2C *lcd)
 {
-  LCDnoBacklight();
-  LCDnoDisplay();
+  LCDbeginModes(lcd);
+  LCDnoBacklight(lcd);
+  LCDnoDisplay(lcd);
+  LCDcommitModes(lcd);
 }
 
 /**************************************************************************/
@@ -838,10 +4188,78 @@ void LCDdisplayOff(void)
     Turns on backlight via PCF8574 & shows text from DDRAM
 */
 /**************************************************************************/
-void LCDdisplayOn(void)
+void LCDdisplayOn(LiquidCrystal_I2C *lcd)
+{
+  LCDbeginModes(lcd);
+  LCDdisplay(lcd);
+  LCDbacklight(lcd);
+  LCDcommitModes(lcd);
+}
+
+/**************************************************************************/
+/*
+    LCDbeginModes()
+
+    Starts collecting display control, text direction, autoscroll &
+    backlight changes, nothing is sent until LCDcommitModes()
+
+    NOTE:
+    - e.g. LCDcursor(), LCDblink(), LCDautoscroll(), LCDbacklight()
+    - commit text direction changes before writing text
+*/
+/**************************************************************************/
+void LCDbeginModes(LiquidCrystal_I2C *lcd)
+{
+  lcd->_modesPending = true;
+}
+
+/**************************************************************************/
+/*
+    LCDcommitModes()
+
+    Sends changes collected since LCDbeginModes()
+
+    NOTE:
+    - at most one display control & one entry mode command, only if the
+      register differs from lcd, see LCDupdateModes()
+    - backlight change rides along with these commands, it costs a
+      PCF8574 byte only if no command was sent
+    - in batch mode everything is sent by LCDendBatch()
+    - returns false if i2c transaction fails
+*/
+/**************************************************************************/
+bool LCDcommitModes(LiquidCrystal_I2C *lcd)
+{
+  bool batch = lcd->_txBatch;
+
+  lcd->_modesPending = false;
+
+  if (batch == false) LCDbeginBatch(lcd);
+
+  LCDupdateModes(lcd);
+
+  if (batch == false) return LCDendBatch(lcd);
+
+  return true;
+}
+
+/**************************************************************************/
+/*
+    LCDupdateModes()
+
+    Sends display control & entry mode registers that differ from lcd
+
+    NOTE:
+    - does nothing between LCDbeginModes() & LCDcommitModes()
+    - registers sent to lcd are tracked by LCDtrackState()
+*/
+/**************************************************************************/
+void LCDupdateModes(LiquidCrystal_I2C *lcd)
 {
-  LCDdisplay();
-  LCDbacklight();
+  if (lcd->_modesPending == true) return;
+
+  if (lcd->_displayControl != lcd->_displayControlSent) LCDsend(lcd, LCD_INSTRUCTION_WRITE, LCD_DISPLAY_CONTROL | lcd->_displayControl, LCD_CMD_LENGTH_8BIT);
+  if (lcd->_displayMode    != lcd->_displayModeSent)    LCDsend(lcd, LCD_INSTRUCTION_WRITE, LCD_ENTRY_MODE_SET  | lcd->_displayMode,    LCD_CMD_LENGTH_8BIT);
 }
 
 /**************************************************************************/
@@ -23,6 +23,7 @@
 #define LiquidCrystal_i2c_h
 
 #include <stdint.h>
+#include <stddef.h>
 
 /* 
    lcd main register commands
@@ -95,9 +96,125 @@ lcd_font_size;
 /* lcd misc. */
 #define LCD_HOME_CLEAR_DELAY     2     //duration of home & clear commands, in milliseconds
 #define LCD_COMMAND_DELAY        43    //duration of command, in microseconds
+#define LCD_POWER_ON_DELAY       45    //lcd internal reset after voltage rises above 2.7v, in milliseconds
+#define LCD_RESET_DELAY          5000  //after 1-st soft reset nibble, > 4.1ms, some lcd even slower than 4.5ms, in microseconds
+#define LCD_RESET_NIBBLE_DELAY   100   //after 2-nd soft reset nibble, > 100us, in microseconds
 #define LCD_CMD_LENGTH_8BIT      8     //8-bit command length
 #define LCD_CMD_LENGTH_4BIT      4     //4-bit command length
 
+/*
+   microseconds delay backend
+   NOTE: DWT cycle counter is used by default on Cortex-M3/M4/M7, define LCD_DELAY_TIMER as
+         handle of free running 1MHz timer (e.g. htim6) for Cortex-M0 or if DWT is used by debugger,
+         define LCD_HOST_STUB for host builds without STM32 HAL
+*/
+//#define LCD_DELAY_TIMER        htim6
+//#define LCD_HOST_STUB
+
+#if !defined(LCD_HOST_STUB)
+#include "main.h"                      //STM32 HAL & CMSIS, I2C_HandleTypeDef
+#endif
+
+/* HAL bus backend */
+#define LCD_I2C_TIMEOUT          10    //blocking i2c transaction timeout, full tx buffer takes ~3ms @ 100kHz, in milliseconds
+#define LCD_I2C_CLOCK            400000 //i2c clock, max. 400kHz, paces native data stream, in Hz
+#define LCD_I2C_BYTE_TIME        (9000000UL / LCD_I2C_CLOCK) //byte & ACK, rounded down, in microseconds
+#define LCD_BUS_BUSY_TIMEOUT     10000 //wait for bus used by other display or device, in microseconds
+
+/*
+   i2c link circuit breaker, see LCDlinkService()
+   NOTE: restore of responding display is spread over several calls, power-on, soft reset & ST7032
+         follower waits are not blocking, the longest call sends CGRAM & screen, ~15ms @ 400kHz on
+         20x4 PCF8574 display
+*/
+#define LCD_LINK_RETRY_PERIOD    500   //probe period of not responding display, in milliseconds
+
+/*
+   PCF8574 port mapping
+   NOTE: define LCD_STANDARD_BACKPACK for {4,5,6,16,11,12,13,14} backpacks, port mapping becomes
+         few constant shifts instead of table lookups
+*/
+//#define LCD_STANDARD_BACKPACK
+
+/* busy flag polling */
+#define LCD_BUSY_FLAG_MIN_DELAY  250   //shortest fixed delay replaced by BF polling, in microseconds
+#define LCD_BUSY_FLAG_POLL_LIMIT 20    //max. BF reads before fall back to fixed delay
+
+/* I2C transmit buffer */
+#define LCD_TX_BUFFER_SIZE       32    //encoded bytes sent in one i2c transaction, 8-bit command takes max. 4 bytes, same as I2C_SCHEDULER_CHUNK
+
+/*
+   lcd backends, see LCDbackend()
+   NOTE: MCP230xx work in byte mode (IOCON.SEQOP=1), every transaction starts with port
+         register & streams to it, MCP23017 (IOCON.BANK=0) toggles between GPIOB & GPIOA
+*/
+#define MCP23008_IODIR           0x00  //I/O direction register, 0 - output
+#define MCP23008_IOCON           0x05  //configuration register
+#define MCP23008_GPIO            0x09  //port register, wired same as PCF8574
+#define MCP23017_IODIRA          0x00  //I/O direction register of port A, IODIRB follows in byte mode
+#define MCP23017_IOCON           0x0A  //configuration register
+#define MCP23017_GPIOB           0x13  //port B register, DB0..DB7, GPIOA follows in byte mode
+#define MCP230XX_IOCON_SEQOP     0x20  //byte mode, address pointer doesn't increment
+#define LCD_NATIVE_COMMAND       0x80  //Co=1, RS=0 control byte of ST7032 & AiP31068, one command follows
+#define LCD_NATIVE_DATA_STREAM   0x40  //Co=0, RS=1 control byte, data till the end of transaction
+#define LCD_NATIVE_DATA          0xC0  //Co=1, RS=1 control byte, one data byte follows
+#define LCD_NATIVE_IDLE          0x00  //Co=0, RS=0 control byte without command, used as probe
+#define ST7032_INSTRUCTION_TABLE 0x01  //IS bit of function set, selects extended instructions
+#define ST7032_OSC_FREQUENCY     0x14  //internal oscillator, 1/5 bias, ~183Hz frame
+#define ST7032_CONTRAST_LOW      0x70  //contrast bits C3..C0
+#define ST7032_POWER_BOOSTER     0x54  //booster on, icons off, contrast bits C5..C4
+#define ST7032_FOLLOWER          0x6C  //voltage follower on, amplifier ratio 4
+#define LCD_ST7032_CONTRAST      0x28  //ST7032 contrast, 0..63
+#define LCD_ST7032_FOLLOWER_DELAY 200  //voltage follower power-up, in milliseconds
+
+/*
+   async engine
+   NOTE: buffer & segments sizes must be power of 2, define LCD_ASYNC_IT to use
+         HAL_I2C_Master_Transmit_IT() instead of HAL_I2C_Master_Transmit_DMA()
+*/
+#define LCD_ASYNC_BUFFER_SIZE    256   //encoded PCF8574 bytes, 64 8-bit commands
+#define LCD_ASYNC_SEGMENTS       16    //queued i2c transactions
+//#define LCD_ASYNC_IT
+
+/*
+   bus statistics
+   NOTE: define LCD_STATISTICS to count i2c transactions, bytes & delays of every display,
+         see LCDstatistics()
+*/
+//#define LCD_STATISTICS
+
+/* framebuffer */
+#define LCD_FRAMEBUFFER_SIZE     80    //max. colums * rows, 80 bytes of DDRAM is enough for 20x4 & 40x2
+#define LCD_REFRESH_PERIOD       40    //default frame period of LCDrefreshTask(), in milliseconds, 25fps
+#define LCD_REFRESH_BUDGET       64    //default bus bytes per LCDrefreshTask() call, ~1.5ms @ 400kHz
+
+/* multi-panel */
+#define LCD_MAX_PANELS           16    //max. panels of LCDbeginPanels(), 8 PCF8574 & 8 PCF8574A addresses on one bus
+
+/* address counter & registers model, see LCDtrackState() */
+#define LCD_ADDRESS_UNKNOWN      0xFF  //DDRAM address is unknown, next LCDsetCursor() is always sent
+#define LCD_ADDRESS_CGRAM        0xFE  //address counter points to CGRAM
+#define LCD_MODE_UNKNOWN         0xFF  //display control or entry mode register is unknown, next change is always sent
+
+/* horizontal graph */
+#define LCD_MAX_ROWS             4     //max. rows supported by DDRAM addressing, see LCDrowAddress()
+#define LCD_GRAPH_UNKNOWN        0xFF  //graph row content is unknown & drawn in full
+
+/* bar graph */
+#define LCD_BAR_H_STEPS          5     //horizontal steps per cell, 5 pixel colums
+#define LCD_BAR_V_STEPS          8     //vertical steps per cell, 8 pixel rows of 5x8 font
+
+/* marquee */
+#define LCD_DDRAM_LINE_SIZE      40    //DDRAM bytes per line in 2-line mode, display shift wraps at the end of the line
+#define LCD_DDRAM_1LINE_SIZE     80    //DDRAM bytes of the only line in 1-line mode, 1 row & 5x10 displays
+
+/* numeric output */
+#define LCD_NUMBER_SIZE          12    //max. characters of formatted number, sign + 10 digits + point
+
+/* CGRAM glyph cache */
+#define LCD_CGRAM_SIZE           64    //CGRAM bytes, 8 patterns of 5x8 or 4 patterns of 5x10 font
+#define LCD_GLYPH_NO_ID          0xFFFF //glyph is cached by pattern, see LCDglyph()
+
 /* PCF8574 misc. controls */
 #define LCD_BACKLIGHT_ON         0x01
 #define LCD_BACKLIGHT_OFF        0x00
@@ -123,7 +240,9 @@ typedef enum : uint8_t
   PCF8574A_ADDR_A20_A11_A01    = 0x3B, //i2c address A2 = 0, A1 = 1, A0 = 1
   PCF8574A_ADDR_A20_A11_A00    = 0x3A, //i2c address A2 = 0, A1 = 1, A0 = 0
   PCF8574A_ADDR_A20_A10_A01    = 0x39, //i2c address A2 = 0, A1 = 0, A0 = 1
-  PCF8574A_ADDR_A20_A10_A00    = 0x38  //i2c address A2 = 0, A1 = 0, A0 = 0
+  PCF8574A_ADDR_A20_A10_A00    = 0x38, //i2c address A2 = 0, A1 = 0, A0 = 0
+
+  LCD_NATIVE_ADDR              = 0x3E  //fixed i2c address of ST7032 & AiP31068, see LCDbackend()
 }
 PCF8574_address;
 
@@ -135,73 +254,385 @@ typedef enum : uint8_t
 }
 backlightPolarity;
 
+/* async engine */
+typedef enum : uint8_t
+{
+  LCD_ASYNC_IDLE               = 0x00, //no transfer, next segment can be started
+  LCD_ASYNC_TRANSFER           = 0x01, //DMA/IT transfer in progress
+  LCD_ASYNC_DELAY              = 0x02  //waiting for command duration, see LCDasyncService()
+}
+lcd_async_state;
+
+/* link restore, see LCDlinkService() */
+typedef enum : uint8_t
+{
+  LCD_LINK_PROBE               = 0x00, //breaker is closed or display is probed once per LCD_LINK_RETRY_PERIOD
+  LCD_LINK_POWER_ON            = 0x01, //display responded, waiting for power-on reset of plugged lcd
+  LCD_LINK_RESET               = 0x02, //1-st soft reset nibble is sent, waiting LCD_RESET_DELAY
+  LCD_LINK_EXTENSION           = 0x03  //controller commands are sent, waiting backend extensionDelay
+}
+lcd_link_step;
+
+typedef struct
+{
+  uint16_t length;                     //encoded PCF8574 bytes
+  uint16_t delay;                      //command duration after transfer, in microseconds
+}
+lcd_async_segment;
+
+/*
+   bus & time backend
+   NOTE: address is 7-bit, backend shifts it if needed, LCDbusHAL is used by LCDinit(),
+         use LCDinitBus() for other buses, e.g. host simulator or bit-banged i2c
+*/
+typedef enum : uint8_t
+{
+  LCD_BUS_OK                   = 0x00, //transaction done or started
+  LCD_BUS_BUSY                 = 0x01, //bus is used by other display or device, try later
+  LCD_BUS_ERROR                = 0x02  //NACK, timeout & etc.
+}
+lcd_bus_status;
+
+typedef struct
+{
+  lcd_bus_status (*write)(void *handle, uint8_t address, const uint8_t *data, uint16_t length);      //blocking write
+  lcd_bus_status (*read)(void *handle, uint8_t address, uint8_t *data, uint16_t length);             //blocking read
+  lcd_bus_status (*writeAsync)(void *handle, uint8_t address, const uint8_t *data, uint16_t length); //DMA/IT write, NULL falls back to blocking write
+  void           (*delay)(uint16_t delay);                                                           //blocking delay, in microseconds
+  uint32_t       (*timestamp)(void);                                                                 //time stamp, any units
+  bool           (*timeElapsed)(uint32_t timestamp, uint16_t delay);                                 //true if delay, in microseconds, passed
+  uint32_t       (*uptime)(void);                                                                    //time since power-up, in milliseconds, NULL waits full LCD_POWER_ON_DELAY
+}
+lcd_bus;
+
+/*
+   lcd interface chip, PCF8574 by default
+   NOTE: port bytes are PCF8574 formated, RS,RW,E & BCK_LED of MCP23017 port A are wired same
+         as PCF8574, framed chips need whole transactions, so async engine is not supported
+*/
+typedef struct
+{
+  uint8_t (*encode)(struct LiquidCrystal_I2C *lcd, uint8_t mode, uint8_t value, uint8_t length, uint8_t *buffer); //returns bytes, 0 - command needs new transaction
+  uint8_t (*port)(struct LiquidCrystal_I2C *lcd, uint8_t value, uint8_t *buffer);                                 //sets chip outputs, see writePCF8574()
+  bool    (*setup)(struct LiquidCrystal_I2C *lcd);                                                                 //chip registers after power-up, may be NULL
+  void    (*extension)(struct LiquidCrystal_I2C *lcd);                                                             //controller commands after soft reset, may be NULL
+  uint16_t  extensionDelay;                                                                                         //wait after extension before display is turned on, in milliseconds
+  uint8_t   prefix;                                                                                                 //first byte of every transaction, e.g. MCP230xx register
+  uint8_t   prefixLength;                                                                                           //0 or 1
+  uint8_t   interface;                                                                                              //LCD_4BIT_MODE or LCD_8BIT_MODE
+  bool      backlight;                                                                                              //backlight is switched by the chip
+  bool      readable;                                                                                               //busy flag can be read, see LCDbusyFlagPolling()
+  bool      framed;                                                                                                 //transaction can't be split
+  uint8_t   dataDelay;                                                                                              //native data write duration, longer than LCD_I2C_BYTE_TIME needs Co=1 pairs, in microseconds
+}
+lcd_backend;
+
+/* bus statistics, see LCDstatistics() */
+typedef struct
+{
+  uint32_t transactions;               //i2c transactions, reads included
+  uint32_t bytes;                      //i2c payload bytes, address bytes not included
+  uint32_t delay;                      //command delays enforced by driver, in microseconds
+  uint32_t errors;                     //failed i2c transactions
+}
+lcd_statistics;
+
+/* bar graph, see LCDbarInit() */
+typedef enum : uint8_t
+{
+  LCD_BAR_HORIZONTAL           = 0x00, //grows left to right, LCD_BAR_H_STEPS per cell
+  LCD_BAR_VERTICAL             = 0x01  //grows bottom to top, LCD_BAR_V_STEPS per cell
+}
+lcd_bar_direction;
+
+typedef struct
+{
+  uint8_t           colum;             //left cell of horizontal bar
+  uint8_t           row;               //bottom cell of vertical bar
+  uint8_t           length;            //in cells
+  lcd_bar_direction direction;
+  uint8_t           glyph;             //CGRAM address of 1-step glyph, see LCDbarGlyphs()
+  uint16_t          level;             //last drawn level, in steps
+  uint16_t          epoch;             //screen epoch of last draw, see LCDgraphReset()
+}
+lcd_bar;
+
+/* number field, see LCDfieldInit() */
+typedef struct
+{
+  uint8_t  colum;
+  uint8_t  row;
+  uint8_t  width;                      //in characters, number is right aligned
+  uint8_t  decimals;                   //digits after point, 0 - integer
+  char     text[LCD_NUMBER_SIZE];      //last drawn characters
+  uint16_t epoch;                      //screen epoch of last draw, see LCDgraphReset()
+}
+lcd_number_field;
+
+/* marquee, see LCDmarqueeInit() */
+typedef struct
+{
+  const char *text;
+  uint16_t    length;                  //text length
+  uint16_t    period;                  //text length, min. DDRAM line size, shorter text is padded with spaces
+  uint16_t    position;                //text index shown in the first visible colum
+  uint16_t    loaded;                  //next text index to load into DDRAM
+  uint8_t     base;                    //DDRAM line slot of text index 0
+  uint8_t     line;                    //DDRAM address of line start, 0x00 or 0x40
+}
+lcd_marquee;
+
+/* display context, one per display */
+typedef struct LiquidCrystal_I2C
+{
+  const lcd_bus            *_bus;
+  void                     *_busHandle;                               //e.g. I2C_HandleTypeDef, passed to every bus call
+  const lcd_backend        *_backend;                                 //interface chip, see LCDbackend()
+  PCF8574_address           _PCF8574_address;
+  lcd_font_size             _lcd_font_size;
+  backlightPolarity         _backlightPolarity;
+  uint8_t                   _displayControl;                          //DO NOT CHANGE!!! default bits value: DB7, DB6, DB5, DB4, DB3, DB2=(D), DB1=(C),   DB0=(B)
+  uint8_t                   _displayMode;                             //DO NOT CHANGE!!! default bits value: DB7, DB6, DB5, DB4, DB3, DB2,     DB1=(I/D), DB0=(S)
+  uint8_t                   _lcd_colums;
+  uint8_t                   _lcd_rows;
+  uint8_t                   _displayShift;                            //hardware display shift, 0..DDRAM line size - 1, see LCDddramLineSize()
+  uint8_t                   _addressCounter;                          //software copy of lcd address counter, see LCDtrackState()
+  uint8_t                   _displayControlSent;                      //_displayControl in lcd register
+  uint8_t                   _displayModeSent;                         //_displayMode in lcd register
+  bool                      _modesPending;                            //mode changes wait for LCDcommitModes()
+  uint8_t                   _backlightValue;
+  uint8_t                   _PCF8574_latch;                           //last byte written to PCF8574 outputs
+  bool                      _PCF8574_latchValid;
+  uint8_t                   _LCD_TO_PCF8574[8];
+  uint8_t                   _portMappingHigh[16];                     //RS,RW,E,DB7 to PCF8574 ports, see LCDportMappingInit()
+  uint8_t                   _portMappingLow[16];                      //DB6,DB5,DB4,BCK_LED to PCF8574 ports
+  bool                      _PCF8574_initialisation;
+  bool                      _linkFault;                               //circuit breaker is open, bus is not used until LCDlinkService()
+  uint32_t                  _linkProbeTime;                           //last probe or restore step, in milliseconds
+  lcd_link_step             _linkStep;                                //restore progress, see LCDlinkService()
+  bool                      _busyFlagPolling;                         //wait for BF instead of fixed delays
+
+  /* i2c transmit buffer */
+  uint8_t                   _txBuffer[LCD_TX_BUFFER_SIZE];            //encoded bytes waiting for i2c transaction, starts with backend prefix
+  uint8_t                   _txLength;
+  uint8_t                   _txStart;                                 //backend prefix length, empty buffer length
+  bool                      _txStream;                                //buffer ends with data stream of native controller
+  bool                      _txBatch;
+
+  /* framebuffer */
+  uint8_t                   _frameBuffer[LCD_FRAMEBUFFER_SIZE];       //wanted screen content, row by row
+  uint8_t                   _frameScreen[LCD_FRAMEBUFFER_SIZE];       //screen content last sent to lcd DDRAM, see LCDtrackState()
+  uint8_t                   _frameCursor;                             //framebuffer write position
+  bool                      _frameBufferMode;
+  bool                      _frameScreenValid;                        //false, lcd DDRAM content unknown
+  uint8_t                   _frameUrgent;                             //bit per row, flushed before other rows
+  uint16_t                  _refreshPeriod;                           //in milliseconds, see LCDrefreshTask()
+  uint16_t                  _refreshBudget;                           //bus bytes per call, see LCDcellCost()
+  uint32_t                  _refreshStart;                            //time stamp of current frame, in milliseconds
+  bool                      _refreshPending;                          //frame is not fully sent yet
+
+  /* horizontal graph */
+  uint8_t                   _graphLength[LCD_MAX_ROWS];               //last drawn bar end colum of every row, see LCDprintHorizontalGraph()
+  char                      _graphName[LCD_MAX_ROWS];
+  uint16_t                  _graphEpoch;                              //changed when drawn graphs & bars are lost, e.g. LCDclear()
+
+  /* CGRAM glyph cache */
+  uint8_t                   _glyphPatterns[LCD_CGRAM_SIZE];           //copy of CGRAM, 8 or 10 bytes per slot
+  uint16_t                  _glyphId[8];                              //LCD_GLYPH_NO_ID, cached by pattern
+  uint16_t                  _glyphUsed[8];                            //LRU time stamp of every slot
+  uint16_t                  _glyphClock;
+  uint8_t                   _glyphValid;                              //bit per slot, 1 - CGRAM matches the copy
+  uint8_t                   _glyphFirst;                              //slots managed by the cache, see LCDglyphCache()
+  uint8_t                   _glyphCount;
+
+  /* async engine */
+  uint8_t                   _asyncBuffer[LCD_ASYNC_BUFFER_SIZE];      //encoded PCF8574 bytes waiting for DMA/IT transfer
+  volatile uint16_t         _asyncHead;
+  volatile uint16_t         _asyncTail;
+  lcd_async_segment         _asyncSegments[LCD_ASYNC_SEGMENTS];       //i2c transactions & delays after them
+  volatile uint8_t          _asyncSegmentHead;
+  volatile uint8_t          _asyncSegmentTail;
+  volatile uint16_t         _asyncChunk;                              //bytes in current transfer
+  volatile uint16_t         _asyncDelay;                              //current delay, in microseconds
+  volatile uint32_t         _asyncDelayStart;
+  volatile lcd_async_state  _asyncState;
+  void                    (*_asyncCallback)(struct LiquidCrystal_I2C *lcd); //called when queue is empty
+
+  #if defined(LCD_STATISTICS)
+  /* bus statistics */
+  lcd_statistics            _statistics;
+  #endif
+}
+LiquidCrystal_I2C;
+
+extern const uint8_t LCDpinMapping[8];
+
+#if !defined(LCD_HOST_STUB)
+extern const lcd_bus LCDbusHAL;
+#endif
+
+extern const lcd_backend LCDbackendPCF8574;
+extern const lcd_backend LCDbackendMCP23008;
+extern const lcd_backend LCDbackendMCP23017;
+extern const lcd_backend LCDbackendST7032;
+extern const lcd_backend LCDbackendAiP31068;
+
 /* This here was under "public:" */
-bool LCDbegin(uint8_t lcd_colums = 16, uint8_t lcd_rows = 2, lcd_font_size = LCD_5x8DOTS);
-void LCDclear(void);
-void LCDhome(void);
-void LCDsetCursor(uint8_t colum, uint8_t row);
-void LCDnoDisplay(void);
-void LCDdisplay(void);
-void LCDnoBlink(void);
-void LCDblink(void);
-void LCDnoCursor(void);
-void LCDcursor(void);
-void LCDscrollDisplayLeft(void);
-void LCDscrollDisplayRight(void);
-void LCDleftToRight(void);
-void LCDrightToLeft(void);
-void LCDautoscroll(void);
-void LCDnoAutoscroll(void); 
-void LCDcreateChar(uint8_t CGRAM_address,       uint8_t *char_pattern);
-void LCDnoBacklight(void);
-void LCDbacklight(void);
-
-void LCDwrite(uint8_t value);
+#if !defined(LCD_HOST_STUB)
+void LCDinit(LiquidCrystal_I2C *lcd, I2C_HandleTypeDef *hi2c, PCF8574_address addr = PCF8574_ADDR_A21_A11_A01, const uint8_t *pinMapping = NULL, backlightPolarity polarity = POSITIVE);
+#endif
+void LCDinitBus(LiquidCrystal_I2C *lcd, const lcd_bus *bus, void *handle, PCF8574_address addr = PCF8574_ADDR_A21_A11_A01, const uint8_t *pinMapping = NULL, backlightPolarity polarity = POSITIVE);
+void LCDbackend(LiquidCrystal_I2C *lcd, const lcd_backend *backend);
+bool LCDbegin(LiquidCrystal_I2C *lcd, uint8_t lcd_colums = 16, uint8_t lcd_rows = 2, lcd_font_size f_size = LCD_5x8DOTS);
+bool LCDbeginWarm(LiquidCrystal_I2C *lcd, uint8_t lcd_colums = 16, uint8_t lcd_rows = 2, lcd_font_size f_size = LCD_5x8DOTS);
+bool LCDbeginPanels(LiquidCrystal_I2C *const *panels, uint8_t count, uint8_t lcd_colums = 16, uint8_t lcd_rows = 2, lcd_font_size f_size = LCD_5x8DOTS);
+void LCDclearPanels(LiquidCrystal_I2C *const *panels, uint8_t count);
+bool LCDflushPanels(LiquidCrystal_I2C *const *panels, uint8_t count);
+void LCDclear(LiquidCrystal_I2C *lcd);
+void LCDhome(LiquidCrystal_I2C *lcd);
+void LCDsetCursor(LiquidCrystal_I2C *lcd, uint8_t colum, uint8_t row);
+void LCDnoDisplay(LiquidCrystal_I2C *lcd);
+void LCDdisplay(LiquidCrystal_I2C *lcd);
+void LCDnoBlink(LiquidCrystal_I2C *lcd);
+void LCDblink(LiquidCrystal_I2C *lcd);
+void LCDnoCursor(LiquidCrystal_I2C *lcd);
+void LCDcursor(LiquidCrystal_I2C *lcd);
+void LCDscrollDisplayLeft(LiquidCrystal_I2C *lcd);
+void LCDscrollDisplayRight(LiquidCrystal_I2C *lcd);
+void LCDmarqueeInit(LiquidCrystal_I2C *lcd, lcd_marquee *marquee, uint8_t row, const char *text);
+void LCDmarqueeStep(LiquidCrystal_I2C *lcd, lcd_marquee *marquee);
+void LCDleftToRight(LiquidCrystal_I2C *lcd);
+void LCDrightToLeft(LiquidCrystal_I2C *lcd);
+void LCDautoscroll(LiquidCrystal_I2C *lcd);
+void LCDnoAutoscroll(LiquidCrystal_I2C *lcd);
+void LCDcreateChar(LiquidCrystal_I2C *lcd, uint8_t CGRAM_address, const uint8_t *char_pattern);
+void LCDcreateChars(LiquidCrystal_I2C *lcd, uint8_t CGRAM_address, uint8_t count, const uint8_t *char_patterns);
+void LCDnoBacklight(LiquidCrystal_I2C *lcd);
+void LCDbacklight(LiquidCrystal_I2C *lcd);
+
+void LCDwrite(LiquidCrystal_I2C *lcd, uint8_t value);
+void LCDwriteBuffer(LiquidCrystal_I2C *lcd, const uint8_t *buffer, uint16_t length);
+void LCDprint(LiquidCrystal_I2C *lcd, const char *text);
+void LCDprintWrap(LiquidCrystal_I2C *lcd, uint8_t colum, uint8_t row, const char *text);
+void LCDprintInt(LiquidCrystal_I2C *lcd, int32_t value, uint8_t width = 0);
+void LCDprintFixed(LiquidCrystal_I2C *lcd, int32_t value, uint8_t decimals, uint8_t width = 0);
+void LCDprintHex(LiquidCrystal_I2C *lcd, uint32_t value, uint8_t width = 0);
+void LCDfieldInit(LiquidCrystal_I2C *lcd, lcd_number_field *field, uint8_t colum, uint8_t row, uint8_t width, uint8_t decimals = 0);
+void LCDfieldInt(LiquidCrystal_I2C *lcd, lcd_number_field *field, int32_t value);
+void LCDfieldHex(LiquidCrystal_I2C *lcd, lcd_number_field *field, uint32_t value);
 
 /*************** !!! arduino not standard API functions !!! ***************/
-void LCDprintHorizontalGraph(char name, uint8_t row, uint16_t currentValue, uint16_t maxValue);
-void LCDdisplayOff(void);
-void LCDdisplayOn(void);  
+void LCDprintHorizontalGraph(LiquidCrystal_I2C *lcd, char name, uint8_t row, uint16_t currentValue, uint16_t maxValue);
+void LCDgraphReset(LiquidCrystal_I2C *lcd);
+bool LCDbarGlyphs(LiquidCrystal_I2C *lcd, lcd_bar_direction direction, uint8_t CGRAM_address);
+void LCDbarInit(LiquidCrystal_I2C *lcd, lcd_bar *bar, uint8_t colum, uint8_t row, uint8_t length, lcd_bar_direction direction, uint8_t CGRAM_address);
+void LCDbarDraw(LiquidCrystal_I2C *lcd, lcd_bar *bar, uint16_t value, uint16_t maxValue);
+void LCDbarsDraw(LiquidCrystal_I2C *lcd, lcd_bar *bars, const uint16_t *values, uint8_t count, uint16_t maxValue);
+void LCDglyphCache(LiquidCrystal_I2C *lcd, uint8_t CGRAM_address, uint8_t count);
+uint8_t LCDglyph(LiquidCrystal_I2C *lcd, const uint8_t *char_pattern);
+uint8_t LCDglyphById(LiquidCrystal_I2C *lcd, uint16_t id, const uint8_t *char_pattern);
+void LCDdisplayOff(LiquidCrystal_I2C *lcd);
+void LCDdisplayOn(LiquidCrystal_I2C *lcd);
+void LCDbeginModes(LiquidCrystal_I2C *lcd);
+bool LCDcommitModes(LiquidCrystal_I2C *lcd);
 void LCDsetBrightness(uint8_t pin, uint8_t value, backlightPolarity polarity);
+void LCDbeginBatch(LiquidCrystal_I2C *lcd);
+bool LCDendBatch(LiquidCrystal_I2C *lcd);
+void LCDdelayInit(void);
+void LCDdelayMicroseconds(uint16_t delay);
+uint32_t LCDtimestamp(void);
+bool LCDtimeElapsed(uint32_t timestamp, uint16_t delay);
+uint32_t LCDuptime(void);
+void LCDbusyFlagPolling(LiquidCrystal_I2C *lcd);
+void LCDnoBusyFlagPolling(LiquidCrystal_I2C *lcd);
+bool LCDframeBuffer(LiquidCrystal_I2C *lcd);
+void LCDnoFrameBuffer(LiquidCrystal_I2C *lcd);
+bool LCDflush(LiquidCrystal_I2C *lcd);
+bool LCDflushAsync(LiquidCrystal_I2C *lcd);
+bool LCDflushBudget(LiquidCrystal_I2C *lcd, uint16_t budget);
+void LCDframeUrgent(LiquidCrystal_I2C *lcd, uint8_t row);
+void LCDrefreshRate(LiquidCrystal_I2C *lcd, uint16_t period, uint16_t budget);
+bool LCDrefreshTask(LiquidCrystal_I2C *lcd, uint32_t now);
+bool LCDwriteAsync(LiquidCrystal_I2C *lcd, uint8_t value);
+bool LCDsetCursorAsync(LiquidCrystal_I2C *lcd, uint8_t colum, uint8_t row);
+bool LCDclearAsync(LiquidCrystal_I2C *lcd);
+void LCDasyncCallback(LiquidCrystal_I2C *lcd, void (*callback)(LiquidCrystal_I2C *lcd));
+bool LCDasyncBusy(LiquidCrystal_I2C *lcd);
+void LCDasyncService(LiquidCrystal_I2C *lcd);
+void LCDasyncTxComplete(LiquidCrystal_I2C *lcd, void *handle);
+void LCDasyncError(LiquidCrystal_I2C *lcd, void *handle);
+void LCDstatistics(LiquidCrystal_I2C *lcd, lcd_statistics *stats);
+void LCDresetStatistics(LiquidCrystal_I2C *lcd);
+bool LCDlinkService(LiquidCrystal_I2C *lcd, uint32_t now);
+bool LCDconnected(LiquidCrystal_I2C *lcd);
 
 /**************************************************************************/
 
 /* This here was under "private:" */
-void initialization(void);
-void    send(uint8_t mode, uint8_t value, uint8_t length);
-inline uint8_t portMapping(uint8_t value);
-bool    writePCF8574(uint8_t value);
-uint8_t readPCF8574(void);
-bool    readBusyFlag(void);
-uint8_t getCursorPosition(void);
+bool    LCDbeginPCF8574(LiquidCrystal_I2C *lcd, uint8_t lcd_colums, uint8_t lcd_rows, lcd_font_size f_size);
+void    LCDinitialization(LiquidCrystal_I2C *lcd);
+void    LCDinitializationPanels(LiquidCrystal_I2C *const *panels, uint8_t count, uint16_t ready);
+void    LCDconfiguration(LiquidCrystal_I2C *lcd);
+void    LCDconfigurationStart(LiquidCrystal_I2C *lcd);
+void    LCDconfigurationEnd(LiquidCrystal_I2C *lcd);
+bool    LCDflushBatch(LiquidCrystal_I2C *lcd);
+bool    LCDsend(LiquidCrystal_I2C *lcd, uint8_t mode, uint8_t value, uint8_t length);
+void    LCDportMappingInit(LiquidCrystal_I2C *lcd);
+uint8_t LCDportMapping(LiquidCrystal_I2C *lcd, uint8_t value);
+bool    writePCF8574(LiquidCrystal_I2C *lcd, uint8_t value);
+bool    LCDflushTxBuffer(LiquidCrystal_I2C *lcd);
+uint8_t LCDencode(LiquidCrystal_I2C *lcd, uint8_t mode, uint8_t value, uint8_t length, uint8_t *buffer);
+uint8_t LCDencodeMCP23017(LiquidCrystal_I2C *lcd, uint8_t mode, uint8_t value, uint8_t length, uint8_t *buffer);
+uint8_t LCDencodeNative(LiquidCrystal_I2C *lcd, uint8_t mode, uint8_t value, uint8_t length, uint8_t *buffer);
+uint8_t LCDportPCF8574(LiquidCrystal_I2C *lcd, uint8_t value, uint8_t *buffer);
+uint8_t LCDportMCP23017(LiquidCrystal_I2C *lcd, uint8_t value, uint8_t *buffer);
+uint8_t LCDportNative(LiquidCrystal_I2C *lcd, uint8_t value, uint8_t *buffer);
+bool    LCDsetupMCP23008(LiquidCrystal_I2C *lcd);
+bool    LCDsetupMCP23017(LiquidCrystal_I2C *lcd);
+void    LCDextensionST7032(LiquidCrystal_I2C *lcd);
+bool    LCDwriteBytes(LiquidCrystal_I2C *lcd, const uint8_t *data, uint8_t length);
+lcd_bus_status LCDbusWrite(LiquidCrystal_I2C *lcd, const uint8_t *data, uint16_t length);
+lcd_bus_status LCDbusRead(LiquidCrystal_I2C *lcd, uint8_t *data, uint16_t length);
+bool    LCDprobe(LiquidCrystal_I2C *lcd);
+void    LCDtrackState(LiquidCrystal_I2C *lcd, uint8_t mode, uint8_t value, uint8_t length);
+void    LCDshiftTrack(LiquidCrystal_I2C *lcd, bool left);
+void    LCDtrackLost(LiquidCrystal_I2C *lcd);
+void    LCDupdateModes(LiquidCrystal_I2C *lcd);
+uint8_t LCDbacklightValue(LiquidCrystal_I2C *lcd, bool on);
+bool    LCDsyncBacklight(LiquidCrystal_I2C *lcd);
+uint8_t LCDnextAddress(LiquidCrystal_I2C *lcd, uint8_t address, bool increment);
+uint8_t LCDddramLineSize(LiquidCrystal_I2C *lcd);
+uint8_t LCDscreenIndex(LiquidCrystal_I2C *lcd, uint8_t address);
+void    LCDlinkRestore(LiquidCrystal_I2C *lcd, const uint8_t *screen, uint8_t address);
+void    LCDlinkConfigure(LiquidCrystal_I2C *lcd);
+void    LCDresetInterface(LiquidCrystal_I2C *lcd);
+void    LCDframeSync(LiquidCrystal_I2C *lcd);
+bool    LCDflushRows(LiquidCrystal_I2C *lcd, uint8_t rows, uint16_t *budget);
+uint8_t LCDcellCost(LiquidCrystal_I2C *lcd, uint8_t address, uint8_t value);
+bool    LCDsendAsync(LiquidCrystal_I2C *lcd, uint8_t mode, uint8_t value, uint8_t length, uint16_t delay);
+bool    LCDasyncStart(LiquidCrystal_I2C *lcd);
+void    LCDasyncDrop(LiquidCrystal_I2C *lcd);
+bool    readPCF8574(LiquidCrystal_I2C *lcd, uint8_t *value);
+bool    LCDreadAddressCounter(LiquidCrystal_I2C *lcd, uint8_t *value);
+void    LCDwaitReady(LiquidCrystal_I2C *lcd, uint16_t delay);
+void    LCDdelay(LiquidCrystal_I2C *lcd, uint16_t delay);
+void    LCDcountTransaction(LiquidCrystal_I2C *lcd, uint16_t length, bool success);
+uint8_t LCDrowAddress(LiquidCrystal_I2C *lcd, uint8_t row, uint8_t colum);
+bool    LCDreadBusyFlag(LiquidCrystal_I2C *lcd);
+uint8_t LCDgetCursorPosition(LiquidCrystal_I2C *lcd);
+void    LCDbarUpdate(LiquidCrystal_I2C *lcd, lcd_bar *bar, uint16_t value, uint16_t maxValue);
+void    LCDmarqueeLoad(LiquidCrystal_I2C *lcd, lcd_marquee *marquee);
+uint8_t LCDbarCell(LiquidCrystal_I2C *lcd, lcd_bar *bar, uint16_t level, uint8_t cell);
+uint8_t LCDformatNumber(char *buffer, uint32_t value, bool negative, uint8_t decimals, uint8_t base, uint8_t width);
+void    LCDfieldUpdate(LiquidCrystal_I2C *lcd, lcd_number_field *field, const char *text);
+uint8_t LCDglyphLoad(LiquidCrystal_I2C *lcd, uint16_t id, const uint8_t *char_pattern);
+uint8_t LCDglyphCode(LiquidCrystal_I2C *lcd, uint8_t slot);
+#if !defined(LCD_HOST_STUB)
+lcd_bus_status LCDhalWrite(void *handle, uint8_t address, const uint8_t *data, uint16_t length);
+lcd_bus_status LCDhalRead(void *handle, uint8_t address, uint8_t *data, uint16_t length);
+lcd_bus_status LCDhalWriteAsync(void *handle, uint8_t address, const uint8_t *data, uint16_t length);
+lcd_bus_status LCDhalStatus(HAL_StatusTypeDef status);
+#endif
 /**************************************************************************/
 
-typedef struct
-{
-  PCF8574_address   _PCF8574_address;
-  lcd_font_size     _lcd_font_size;
-  backlightPolarity _backlightPolarity;	
-}LiquidCrystal_I2C;
-
-class LiquidCrystal_I2C : public Print 
-{
-  public:
-   LiquidCrystal_I2C(PCF8574_address = PCF8574_ADDR_A21_A11_A01, uint8_t P0 = 4, uint8_t P1 = 5, uint8_t P2 = 6, uint8_t P3 = 16, uint8_t P4 = 11, uint8_t P5 = 12, uint8_t P6 = 13, uint8_t P7 = 14, backlightPolarity = POSITIVE);
- 
-   
-	 
-  private:
-   uint8_t _displayControl = 0; //DO NOT CHANGE!!! default bits value: DB7, DB6, DB5, DB4, DB3, DB2=(D), DB1=(C),   DB0=(B)
-   uint8_t _displayMode    = 0; //DO NOT CHANGE!!! default bits value: DB7, DB6, DB5, DB4, DB3, DB2,     DB1=(I/D), DB0=(S)
-   uint8_t _lcd_colums;
-   uint8_t _lcd_rows;
-   uint8_t _backlightValue;
-   uint8_t _LCD_TO_PCF8574[8];
-   bool    _PCF8574_initialisation;
-
-   
-
-         
-};
-
 #endif
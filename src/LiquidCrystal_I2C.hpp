@@ -0,0 +1,208 @@
+/***************************************************************************************************/
+/*
+   This is a library for HD44780, S6A0069, KS0066U, NT3881D, LC7985, ST7066, SPLC780,
+   WH160xB, AIP31066, GDM200xD, ADM0802A LCD displays.
+
+   Compile-time specialized front end for panels with fixed geometry & PCF8574 pins mapping.
+   Row offsets, clamps & port mapping are folded into constants, everything else is done by
+   the C driver in LiquidCrystal_I2C.c.
+
+   written by : enjoyneering79, edited by Jojo-A
+   sourse code: https://github.com/enjoyneering/
+
+   GNU GPL license, all text above must be included in any redistribution,
+   see link for details  - https://www.gnu.org/licenses/licenses.html
+*/
+/***************************************************************************************************/
+
+#ifndef LiquidCrystal_i2c_hpp
+#define LiquidCrystal_i2c_hpp
+
+#include "LiquidCrystal_I2C.h"
+
+/*
+   PCF8574 port of every lcd pin
+   NOTE: LCDmapping<0,1,2,3,4,5,6,7> is {4,5,6,16,11,12,13,14} backpack, see README.md
+*/
+template <uint8_t RS, uint8_t RW, uint8_t E, uint8_t BL, uint8_t DB4, uint8_t DB5, uint8_t DB6, uint8_t DB7>
+struct LCDmapping
+{
+  static_assert((RS < 8) && (RW < 8) && (E < 8) && (BL < 8) && (DB4 < 8) && (DB5 < 8) && (DB6 < 8) && (DB7 < 8), "PCF8574 has ports P0..P7 only");
+  static_assert(((1 << RS) | (1 << RW) | (1 << E) | (1 << BL) | (1 << DB4) | (1 << DB5) | (1 << DB6) | (1 << DB7)) == 0xFF, "every PCF8574 port has to be used once");
+
+  static const uint8_t enable = 1 << E; //E port mask
+
+  /* same as LCDportMapping(), input formated as RS,RW,E,DB7,DB6,DB5,DB4,BCK_LED */
+  static constexpr uint8_t map(uint8_t value)
+  {
+    return (uint8_t)((((value >> 7) & 0x01) << RS)  |
+                     (((value >> 6) & 0x01) << RW)  |
+                     (((value >> 5) & 0x01) << E)   |
+                     (((value >> 4) & 0x01) << DB7) |
+                     (((value >> 3) & 0x01) << DB6) |
+                     (((value >> 2) & 0x01) << DB5) |
+                     (((value >> 1) & 0x01) << DB4) |
+                     (( value       & 0x01) << BL));
+  }
+
+  /* lcd pin connected to PCF8574 port, same format as LCDpinMapping[] */
+  static constexpr uint8_t pin(uint8_t port)
+  {
+    return (port == RS)  ? 4  :
+           (port == RW)  ? 5  :
+           (port == E)   ? 6  :
+           (port == BL)  ? 16 :
+           (port == DB4) ? 11 :
+           (port == DB5) ? 12 :
+           (port == DB6) ? 13 : 14;
+  }
+};
+
+typedef LCDmapping<0, 1, 2, 3, 4, 5, 6, 7> LCDstandardMapping;
+
+/*
+   lcd with fixed geometry, font & pins mapping
+   NOTE: context is the usual C driver context, all LCD...() functions can be used with it,
+         send() encodes PCF8574 bytes for PCF8574 & MCP23008 backends, other backends are
+         passed to LCDsend(), see LCDbackend()
+*/
+template <uint8_t Cols, uint8_t Rows, lcd_font_size Font = LCD_5x8DOTS, class Mapping = LCDstandardMapping>
+class LCD
+{
+  static_assert((Cols > 0) && (Cols <= 40),                "lcd has 1..40 colums");
+  static_assert((Rows > 0) && (Rows <= LCD_MAX_ROWS),      "lcd has 1..4 rows");
+  static_assert((Rows * Cols) <= 80,                       "HD44780 DDRAM has 80 bytes");
+  static_assert((Font == LCD_5x8DOTS) || (Rows == 1),      "5x10 font is for 1 row displays only");
+
+  public:
+    LiquidCrystal_I2C context;
+
+    /* DDRAM address of the colum & row, clamped same way as LCDsetCursor() */
+    static constexpr uint8_t address(uint8_t colum, uint8_t row)
+    {
+      return rowOffset((row < Rows) ? row : (Rows - 1)) + ((colum < Cols) ? colum : (Cols - 1));
+    }
+
+    #if !defined(LCD_HOST_STUB)
+    void init(I2C_HandleTypeDef *hi2c, PCF8574_address addr = PCF8574_ADDR_A21_A11_A01, backlightPolarity polarity = POSITIVE)
+    {
+      const uint8_t pins[8] = {Mapping::pin(0), Mapping::pin(1), Mapping::pin(2), Mapping::pin(3), Mapping::pin(4), Mapping::pin(5), Mapping::pin(6), Mapping::pin(7)};
+
+      LCDinit(&context, hi2c, addr, pins, polarity);
+    }
+    #endif
+
+    void initBus(const lcd_bus *bus, void *handle, PCF8574_address addr = PCF8574_ADDR_A21_A11_A01, backlightPolarity polarity = POSITIVE)
+    {
+      const uint8_t pins[8] = {Mapping::pin(0), Mapping::pin(1), Mapping::pin(2), Mapping::pin(3), Mapping::pin(4), Mapping::pin(5), Mapping::pin(6), Mapping::pin(7)};
+
+      LCDinitBus(&context, bus, handle, addr, pins, polarity);
+    }
+
+    bool begin()
+    {
+      return LCDbegin(&context, Cols, Rows, Font);
+    }
+
+    /* runtime position, clamp & row offset are a few instructions */
+    void setCursor(uint8_t colum, uint8_t row)
+    {
+      if (context._frameBufferMode == true)
+      {
+        LCDsetCursor(&context, colum, row);
+        return;
+      }
+
+      if (address(colum, row) == context._addressCounter) return; //lcd is already there, see LCDtrackState()
+
+      if (context._displayModeSent == LCD_MODE_UNKNOWN) LCDupdateModes(&context); //see LCDtrackLost()
+
+      send(LCD_INSTRUCTION_WRITE, LCD_DDRAM_ADDR_SET | address(colum, row));
+    }
+
+    /* compile-time position, checked by compiler & sent as constant */
+    template <uint8_t colum, uint8_t row>
+    void setCursor()
+    {
+      static_assert((colum < Cols) && (row < Rows), "cursor position is out of the screen");
+
+      if (context._frameBufferMode == true)
+      {
+        LCDsetCursor(&context, colum, row);
+        return;
+      }
+
+      if (address(colum, row) == context._addressCounter) return;
+
+      if (context._displayModeSent == LCD_MODE_UNKNOWN) LCDupdateModes(&context);
+
+      send(LCD_INSTRUCTION_WRITE, LCD_DDRAM_ADDR_SET | address(colum, row));
+    }
+
+    void write(uint8_t value)
+    {
+      if (context._frameBufferMode == true)
+      {
+        LCDwrite(&context, value);
+        return;
+      }
+
+      send(LCD_DATA_WRITE, value);
+    }
+
+    void print(const char *text)
+    {
+      bool batch = context._txBatch;
+
+      if (batch == false) LCDbeginBatch(&context);
+
+      while (*text != '\0') write(*text++);
+
+      if (batch == false) LCDendBatch(&context);
+    }
+
+    void clear()
+    {
+      LCDclear(&context);
+    }
+
+  private:
+    static constexpr uint8_t rowOffset(uint8_t row)
+    {
+      return ((row & 0x01) ? 0x40 : 0x00) + ((row & 0x02) ? Cols : 0x00); //row 2 & row 3 are the continuation of row 0 & row 1
+    }
+
+    /* same as LCDsend() & LCDencode(), mapping is folded by compiler */
+    void send(uint8_t mode, uint8_t value)
+    {
+      uint8_t *buffer = 0;
+      uint8_t  high   = Mapping::map(mode | ((value >> 3) & 0x1E)) | context._backlightValue; //RS,RW,E=1,DB7,DB6,DB5,DB4,BCK_LED
+      uint8_t  low    = Mapping::map(mode | ((value << 1) & 0x1E)) | context._backlightValue; //RS,RW,E=1,DB3,DB2,DB1,DB0,BCK_LED
+
+      if (context._backend->encode != LCDencode)          //e.g. native controller or MCP23017, bytes of other chip
+      {
+        LCDsend(&context, mode, value, LCD_CMD_LENGTH_8BIT);
+        return;
+      }
+
+      if ((context._txLength + 4) > LCD_TX_BUFFER_SIZE) LCDflushTxBuffer(&context);
+
+      buffer = &context._txBuffer[context._txLength];
+
+      buffer[0] = high;                                   //send command
+      buffer[1] = high & ~Mapping::enable;                //execute command
+      buffer[2] = low;
+      buffer[3] = low  & ~Mapping::enable;
+
+      context._txLength += 4;
+
+      LCDtrackState(&context, mode, value, LCD_CMD_LENGTH_8BIT);
+
+      if (context._txBatch == true) return;
+
+      LCDflushTxBuffer(&context);
+      LCDwaitReady(&context, LCD_COMMAND_DELAY);
+    }
+};
+
+#endif
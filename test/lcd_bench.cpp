@@ -0,0 +1,226 @@
+/***************************************************************************************************/
+/*
+   Cost of LiquidCrystal_I2C API calls on host simulator, see lcd_sim.h
+
+   Usage: lcd_bench [--csv], JSON by default
+
+   Every call is repeated & averaged per call:
+   - transactions, bytes & delay_us are driver statistics, see LCDstatistics()
+   - bus_us is virtual time of i2c bytes & delays @ SIM_BUS_CLOCK
+   - cpu_ns is host CPU time of driver code, simulator included
+
+   written by : enjoyneering79, edited by Jojo-A
+   sourse code: https://github.com/enjoyneering/
+
+   GNU GPL license, all text above must be included in any redistribution,
+   see link for details  - https://www.gnu.org/licenses/licenses.html
+*/
+/***************************************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "lcd_sim.h"
+
+#define BENCH_ITERATIONS 200                 //calls per measurement
+
+static sim_bus           bus;
+static sim_lcd           sim;
+static LiquidCrystal_I2C lcd;
+static bool              csv   = false;
+static bool              first = true;
+
+
+typedef struct
+{
+  const char        *name;
+  sim_chip           chip;
+  const lcd_backend *backend;
+}
+bench_backend;
+
+typedef struct
+{
+  const char *name;
+  void      (*call)(uint16_t i);
+}
+bench_call;
+
+
+/**************************************************************************/
+/*
+    cpuTime()
+
+    Host CPU time of process, in nanoseconds
+*/
+/**************************************************************************/
+static uint64_t cpuTime(void)
+{
+  struct timespec now;
+
+  clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &now);
+
+  return ((uint64_t)now.tv_sec * 1000000000ULL) + now.tv_nsec;
+}
+
+/**************************************************************************/
+/*
+    calls, i is iteration, every call changes something so nothing is
+    skipped by the driver
+*/
+/**************************************************************************/
+static void callClear(uint16_t i)
+{
+  (void)i;
+
+  LCDclear(&lcd);
+}
+
+static void callSetCursor(uint16_t i)
+{
+  LCDsetCursor(&lcd, (i & 0x01) ? 0 : 5, (i & 0x01) ? 0 : 1);
+}
+
+static void callWrite(uint16_t i)
+{
+  LCDwrite(&lcd, 'A' + (i % 26));
+}
+
+static void callCreateChar(uint16_t i)
+{
+  uint8_t pattern[8] = {0};
+
+  memset(pattern, i & 0x1F, sizeof(pattern));
+
+  LCDcreateChar(&lcd, i & 0x07, pattern);
+}
+
+static void callHorizontalGraph(uint16_t i)
+{
+  LCDprintHorizontalGraph(&lcd, 'A', 1, (i & 0x01) ? 700 : 300, 1000);
+}
+
+static void callScreenRefresh(uint16_t i)
+{
+  char text[LCD_DDRAM_LINE_SIZE + 1] = {0};
+
+  memset(text, (i & 0x01) ? 'x' : 'o', 20);
+
+  for (uint8_t row = 0; row < 4; row++)
+  {
+    LCDsetCursor(&lcd, 0, row);
+    LCDprint(&lcd, text);
+  }
+}
+
+static void callFrameRefresh(uint16_t i)
+{
+  callScreenRefresh(i);                              //framebuffer mode, see measure()
+  LCDflush(&lcd);
+}
+
+/**************************************************************************/
+/*
+    report()
+
+    Prints one measurement as JSON object or CSV line
+*/
+/**************************************************************************/
+static void report(const char *backend, const char *call, const lcd_statistics *stats, uint64_t bus_ns, uint64_t cpu_ns)
+{
+  double n = BENCH_ITERATIONS;
+
+  if (csv == true)
+  {
+    if (first == true) printf("backend,call,transactions,bytes,delay_us,bus_us,cpu_ns\n");
+
+    printf("%s,%s,%.2f,%.2f,%.1f,%.1f,%.0f\n", backend, call, stats->transactions / n, stats->bytes / n, stats->delay / n, bus_ns / n / 1000.0, cpu_ns / n);
+  }
+  else
+  {
+    printf("%s  {\"backend\": \"%s\", \"call\": \"%s\", \"transactions\": %.2f, \"bytes\": %.2f, \"delay_us\": %.1f, \"bus_us\": %.1f, \"cpu_ns\": %.0f}",
+           (first == true) ? "[\n" : ",\n", backend, call, stats->transactions / n, stats->bytes / n, stats->delay / n, bus_ns / n / 1000.0, cpu_ns / n);
+  }
+
+  first = false;
+}
+
+/**************************************************************************/
+/*
+    measure()
+
+    Begins 20x4 lcd on simulated chip & averages call cost
+*/
+/**************************************************************************/
+static void measure(const bench_backend *backend, const bench_call *call, bool frameBuffer)
+{
+  bool            native  = (backend->chip == SIM_ST7032) || (backend->chip == SIM_AIP31068);
+  PCF8574_address address = (native == true) ? LCD_NATIVE_ADDR : PCF8574_ADDR_A21_A11_A01;
+  lcd_statistics  stats;
+  uint64_t        bus_ns  = 0;
+  uint64_t        cpu_ns  = 0;
+
+  SIMreset();
+  SIMbusInit(&bus);
+  SIMattach(&bus, &sim, backend->chip, address);
+
+  LCDinitBus(&lcd, &SIMbusBackend, &bus, address);
+  LCDbackend(&lcd, backend->backend);
+  LCDbegin(&lcd, 20, 4);
+
+  if (frameBuffer == true) LCDframeBuffer(&lcd);
+
+  LCDresetStatistics(&lcd);
+
+  bus_ns = SIMnow;
+  cpu_ns = cpuTime();
+
+  for (uint16_t i = 0; i < BENCH_ITERATIONS; i++) call->call(i);
+
+  cpu_ns = cpuTime() - cpu_ns;
+  bus_ns = SIMnow - bus_ns;
+
+  LCDstatistics(&lcd, &stats);
+
+  report(backend->name, call->name, &stats, bus_ns, cpu_ns);
+
+  if (sim.violations != 0) fprintf(stderr, "%s %s: %u timing violations, %s\n", backend->name, call->name, (unsigned)sim.violations, sim.lastViolation);
+}
+
+int main(int argc, char **argv)
+{
+  const bench_backend backends[] =
+  {
+    {"PCF8574",  SIM_PCF8574,  &LCDbackendPCF8574},
+    {"MCP23008", SIM_MCP23008, &LCDbackendMCP23008},
+    {"MCP23017", SIM_MCP23017, &LCDbackendMCP23017},
+    {"ST7032",   SIM_ST7032,   &LCDbackendST7032},
+    {"AiP31068", SIM_AIP31068, &LCDbackendAiP31068}
+  };
+
+  const bench_call calls[] =
+  {
+    {"LCDclear",                callClear},
+    {"LCDsetCursor",            callSetCursor},
+    {"LCDwrite",                callWrite},
+    {"LCDcreateChar",           callCreateChar},
+    {"LCDprintHorizontalGraph", callHorizontalGraph},
+    {"screen refresh",          callScreenRefresh}
+  };
+
+  const bench_call frame = {"LCDflush refresh", callFrameRefresh};
+
+  csv = (argc > 1) && (strcmp(argv[1], "--csv") == 0);
+
+  for (uint8_t b = 0; b < (sizeof(backends) / sizeof(backends[0])); b++)
+  {
+    for (uint8_t c = 0; c < (sizeof(calls) / sizeof(calls[0])); c++) measure(&backends[b], &calls[c], false);
+
+    measure(&backends[b], &frame, true);
+  }
+
+  if (csv == false) printf("\n]\n");
+
+  return 0;
+}
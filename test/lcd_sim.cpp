@@ -0,0 +1,727 @@
+/***************************************************************************************************/
+/*
+   Host simulator of i2c lcd backpacks for LiquidCrystal_I2C library tests & benchmarks,
+   see lcd_sim.h
+
+   written by : enjoyneering79, edited by Jojo-A
+   sourse code: https://github.com/enjoyneering/
+
+   GNU GPL license, all text above must be included in any redistribution,
+   see link for details  - https://www.gnu.org/licenses/licenses.html
+*/
+/***************************************************************************************************/
+
+#include <string.h>
+
+#include "lcd_sim.h"
+
+#define SIM_PIN_RS       0x01                //PCF8574 P0, standard backpack wiring
+#define SIM_PIN_RW       0x02                //PCF8574 P1
+#define SIM_PIN_E        0x04                //PCF8574 P2
+#define SIM_DB3_DB0_PULL 0x0F                //DB3..DB0 are not wired in 4-bit backpacks, lcd pulls them up
+
+const lcd_bus SIMbusBackend = {SIMwrite, SIMread, NULL, SIMdelay, SIMtimestamp, SIMtimeElapsed, SIMuptime};
+
+uint64_t        SIMnow      = 0;
+static uint64_t SIMbyteTime = 9000000000ULL / SIM_BUS_CLOCK; //8 bits & ACK, in nanoseconds
+
+
+/**************************************************************************/
+/*
+    SIMviolation()
+
+    Counts timing or protocol violation of controller
+*/
+/**************************************************************************/
+static void SIMviolation(sim_lcd *lcd, const char *reason)
+{
+  lcd->violations++;
+  lcd->lastViolation = reason;
+}
+
+/**************************************************************************/
+/*
+    SIMcommandTime()
+
+    Returns instruction execution time of controller, in nanoseconds
+
+    NOTE:
+    - clear & home are long instructions, data write adds tADD of HD44780
+*/
+/**************************************************************************/
+static uint64_t SIMcommandTime(const sim_lcd *lcd, bool longInstruction, bool data)
+{
+  switch (lcd->chip)
+  {
+    case SIM_ST7032:
+      return (longInstruction == true) ? 1080000 : 26300;
+
+    case SIM_AIP31068:
+      return (longInstruction == true) ? 1530000 : 43000;
+
+    default:
+      if (longInstruction == true) return 1520000;
+      return (data == true) ? 41000 : 37000;
+  }
+}
+
+/**************************************************************************/
+/*
+    SIMnextAddress()
+
+    Moves DDRAM address counter, same as HD44780
+
+    NOTE:
+    - 1-line mode DDRAM is 0x00..0x4F, 2-line mode 0x00..0x27 & 0x40..0x67
+*/
+/**************************************************************************/
+static uint8_t SIMnextAddress(const sim_lcd *lcd, uint8_t address, bool increment)
+{
+  if (lcd->twoLine == false)
+  {
+    if (increment == true) return (address >= 0x4F) ? 0x00 : (address + 1);
+    return (address == 0x00) ? 0x4F : (address - 1);
+  }
+
+  if (increment == true)
+  {
+    if (address == 0x27) return 0x40;
+    if (address == 0x67) return 0x00;
+    return address + 1;
+  }
+
+  if (address == 0x00) return 0x67;
+  if (address == 0x40) return 0x27;
+  return address - 1;
+}
+
+/**************************************************************************/
+/*
+    SIMshiftDisplay()
+
+    Moves visible window of every DDRAM line, left shift shows next colum
+*/
+/**************************************************************************/
+static void SIMshiftDisplay(sim_lcd *lcd, bool left)
+{
+  uint8_t lineSize = (lcd->twoLine == true) ? 40 : 80;
+
+  lcd->shift = (left == true) ? ((lcd->shift + 1) % lineSize) : ((lcd->shift + lineSize - 1) % lineSize);
+}
+
+/**************************************************************************/
+/*
+    SIMextended()
+
+    Executes ST7032 extended instruction, IS=1
+
+    NOTE:
+    - only voltage follower is modeled, display must not be turned on
+      before follower settles, see SIM_FOLLOWER_TIME
+*/
+/**************************************************************************/
+static void SIMextended(sim_lcd *lcd, uint8_t value)
+{
+  if (((value & 0xF0) == 0x60) && ((value & 0x08) != 0)) lcd->followerOn = SIMnow;
+}
+
+/**************************************************************************/
+/*
+    SIMexecute()
+
+    Executes instruction or data write, busy flag stays set for
+    instruction duration
+*/
+/**************************************************************************/
+static void SIMexecute(sim_lcd *lcd, bool rs, uint8_t value)
+{
+  bool     native   = (lcd->chip == SIM_ST7032) || (lcd->chip == SIM_AIP31068);
+  uint64_t duration = SIMcommandTime(lcd, false, rs);
+
+  if (rs == true)
+  {
+    lcd->writes++;
+
+    if (lcd->cgramSelected == true)
+    {
+      lcd->cgram[lcd->addressCounter & 0x3F] = value;
+      lcd->addressCounter = (lcd->increment == true) ? ((lcd->addressCounter + 1) & 0x3F) : ((lcd->addressCounter - 1) & 0x3F);
+    }
+    else
+    {
+      lcd->ddram[lcd->addressCounter & 0x7F] = value;
+      lcd->addressCounter = SIMnextAddress(lcd, lcd->addressCounter, lcd->increment);
+
+      if (lcd->shiftOnWrite == true) SIMshiftDisplay(lcd, lcd->increment);
+    }
+
+    lcd->busyUntil = SIMnow + duration;
+    return;
+  }
+
+  lcd->instructions++;
+
+  if (value & 0x80)                                  //set DDRAM address
+  {
+    lcd->addressCounter = value & 0x7F;
+    lcd->cgramSelected  = false;
+  }
+  else if ((native == true) && (lcd->instructionTable == true) && ((value & 0xE0) != 0x20) && (value >= 0x10))
+  {
+    SIMextended(lcd, value);
+  }
+  else if (value & 0x40)                             //set CGRAM address
+  {
+    lcd->addressCounter = value & 0x3F;
+    lcd->cgramSelected  = true;
+  }
+  else if (value & 0x20)                             //function set
+  {
+    if ((native == false) && (lcd->fourBit == false) && (lcd->resetStage < 2))
+    {
+      duration = (lcd->resetStage == 0) ? SIM_FIRST_RESET_TIME : SIM_SECOND_RESET_TIME;
+      lcd->resetStage++;
+    }
+
+    lcd->fourBit          = (value & 0x10) == 0;
+    lcd->twoLine          = (value & 0x08) != 0;
+    lcd->font5x10         = (value & 0x04) != 0;
+    lcd->instructionTable = (native == true) && ((value & 0x01) != 0);
+    lcd->nibblePending    = false;
+  }
+  else if (value & 0x10)                             //cursor or display shift
+  {
+    if (value & 0x08)                    SIMshiftDisplay(lcd, (value & 0x04) == 0);
+    else if (lcd->cgramSelected == true) lcd->addressCounter = (value & 0x04) ? ((lcd->addressCounter + 1) & 0x3F) : ((lcd->addressCounter - 1) & 0x3F);
+    else                                 lcd->addressCounter = SIMnextAddress(lcd, lcd->addressCounter, (value & 0x04) != 0);
+  }
+  else if (value & 0x08)                             //display control
+  {
+    lcd->displayControl = value & 0x07;
+
+    if ((lcd->chip == SIM_ST7032) && ((value & 0x04) != 0) && ((lcd->followerOn == 0) || (SIMnow < (lcd->followerOn + SIM_FOLLOWER_TIME))))
+    {
+      SIMviolation(lcd, "display on before ST7032 follower settled");
+    }
+  }
+  else if (value & 0x04)                             //entry mode
+  {
+    lcd->increment    = (value & 0x02) != 0;
+    lcd->shiftOnWrite = (value & 0x01) != 0;
+  }
+  else if (value & 0x02)                             //return home
+  {
+    lcd->addressCounter = 0x00;
+    lcd->cgramSelected  = false;
+    lcd->shift          = 0;
+    duration            = SIMcommandTime(lcd, true, false);
+  }
+  else if (value & 0x01)                             //clear display, I/D=1, S unchanged
+  {
+    memset(lcd->ddram, 0x20, sizeof(lcd->ddram));
+
+    lcd->addressCounter = 0x00;
+    lcd->cgramSelected  = false;
+    lcd->increment      = true;
+    lcd->shift          = 0;
+    duration            = SIMcommandTime(lcd, true, false);
+  }
+
+  lcd->busyUntil = SIMnow + duration;
+}
+
+/**************************************************************************/
+/*
+    SIMcheckReady()
+
+    Counts violation if controller gets instruction or data while busy,
+    power-on reset included
+*/
+/**************************************************************************/
+static void SIMcheckReady(sim_lcd *lcd)
+{
+  if (SIMnow >= lcd->busyUntil) return;
+
+  SIMviolation(lcd, "instruction while busy");
+}
+
+/**************************************************************************/
+/*
+    SIMlatch()
+
+    HD44780 latches DB7..DB0 on E falling edge, 4-bit interface takes
+    high nibble first
+*/
+/**************************************************************************/
+static void SIMlatch(sim_lcd *lcd, bool rs, uint8_t value)
+{
+  lcd->readLowNibble = false;
+
+  if (lcd->fourBit == true)
+  {
+    if (lcd->nibblePending == false)
+    {
+      SIMcheckReady(lcd);
+
+      lcd->nibble        = value & 0xF0;
+      lcd->nibblePending = true;
+      return;
+    }
+
+    lcd->nibblePending = false;
+
+    SIMexecute(lcd, rs, lcd->nibble | (value >> 4));
+    return;
+  }
+
+  SIMcheckReady(lcd);
+  SIMexecute(lcd, rs, value);
+}
+
+/**************************************************************************/
+/*
+    SIMpins()
+
+    New state of lcd pins RS,RW,E & DB7..DB0
+
+    NOTE:
+    - RS & data have to be stable while E falls, E-low byte of driver
+      repeats E-high byte
+*/
+/**************************************************************************/
+static void SIMpins(sim_lcd *lcd, uint8_t pins, uint8_t bus)
+{
+  if (((lcd->pins & SIM_PIN_E) != 0) && ((pins & SIM_PIN_E) == 0))
+  {
+    if (lcd->pins & SIM_PIN_RW)
+    {
+      if (lcd->fourBit == true) lcd->readLowNibble = !lcd->readLowNibble;
+    }
+    else
+    {
+      if ((((lcd->pins ^ pins) & (SIM_PIN_RS | SIM_PIN_RW)) != 0) || (lcd->bus != bus)) SIMviolation(lcd, "data changed with E falling edge");
+
+      SIMlatch(lcd, (lcd->pins & SIM_PIN_RS) != 0, lcd->bus);
+    }
+  }
+
+  lcd->pins = pins;
+  lcd->bus  = bus;
+}
+
+/**************************************************************************/
+/*
+    SIMreadBus()
+
+    Returns DB7..DB0 driven by lcd, busy flag & address counter
+
+    NOTE:
+    - 4-bit interface returns BF,AC6..AC4 first, then AC3..AC0
+*/
+/**************************************************************************/
+static uint8_t SIMreadBus(const sim_lcd *lcd)
+{
+  uint8_t value = lcd->addressCounter & 0x7F;
+
+  if (SIMnow < lcd->busyUntil) value |= 0x80;
+
+  if ((lcd->fourBit == true) && (lcd->readLowNibble == true)) value <<= 4;
+
+  return value;
+}
+
+/**************************************************************************/
+/*
+    SIMport()
+
+    Byte written to PCF8574 or MCP23008 port, standard backpack wiring
+*/
+/**************************************************************************/
+static void SIMport(sim_lcd *lcd, uint8_t value)
+{
+  SIMpins(lcd, value & 0x0F, (value & 0xF0) | SIM_DB3_DB0_PULL);
+}
+
+/**************************************************************************/
+/*
+    SIMmcpOutputs()
+
+    Drives lcd pins from MCP230xx output latches, input pins float low
+*/
+/**************************************************************************/
+static void SIMmcpOutputs(sim_lcd *lcd)
+{
+  uint8_t *r = lcd->registers;
+
+  if (lcd->chip == SIM_MCP23008)
+  {
+    SIMport(lcd, r[0x0A] & ~r[0x00]);                //OLAT & ~IODIR
+    return;
+  }
+
+  SIMpins(lcd, (r[0x14] & ~r[0x00]) & 0x0F, r[0x15] & ~r[0x01]); //port A RS,RW,E,BCK_LED, port B DB7..DB0
+}
+
+/**************************************************************************/
+/*
+    SIMmcpWrite()
+
+    Writes MCP230xx register pointed by address pointer
+
+    NOTE:
+    - GPIO write goes to output latch
+    - IOCON.SEQOP=1 keeps MCP23008 pointer & toggles MCP23017 pointer
+      between A/B pair, IOCON.BANK=0
+*/
+/**************************************************************************/
+static void SIMmcpWrite(sim_lcd *lcd, uint8_t value)
+{
+  uint8_t size  = (lcd->chip == SIM_MCP23008) ? 0x0B : 0x16;
+  uint8_t iocon = (lcd->chip == SIM_MCP23008) ? 0x05 : 0x0A;
+  uint8_t reg   = lcd->pointer;
+
+  if      ((lcd->chip == SIM_MCP23008) && (reg == 0x09))                 reg = 0x0A;      //GPIO -> OLAT
+  else if ((lcd->chip == SIM_MCP23017) && ((reg == 0x12) || (reg == 0x13))) reg += 2;     //GPIOA/B -> OLATA/B
+
+  lcd->registers[reg] = value;
+
+  if ((lcd->chip == SIM_MCP23017) && ((reg == 0x0A) || (reg == 0x0B))) lcd->registers[0x0A] = lcd->registers[0x0B] = value; //one IOCON, two addresses
+
+  SIMmcpOutputs(lcd);
+
+  if      ((lcd->registers[iocon] & MCP230XX_IOCON_SEQOP) == 0) lcd->pointer = (lcd->pointer + 1) % size;
+  else if (lcd->chip == SIM_MCP23017)                           lcd->pointer ^= 0x01;
+}
+
+/**************************************************************************/
+/*
+    SIMnativeWrite()
+
+    ST7032 & AiP31068 i2c byte, control byte Co,RS selects what follows
+
+    NOTE:
+    - Co=1, one byte follows & then next control byte
+    - Co=0, the rest of transaction is data or instructions
+*/
+/**************************************************************************/
+static void SIMnativeWrite(sim_lcd *lcd, uint8_t value, uint8_t *control)
+{
+  if (lcd->control == true)
+  {
+    *control     = value;
+    lcd->control = false;
+    return;
+  }
+
+  SIMcheckReady(lcd);
+  SIMexecute(lcd, (*control & 0x40) != 0, value);
+
+  if (*control & 0x80) lcd->control = true;          //Co=1
+}
+
+/**************************************************************************/
+/*
+    SIMreset()
+
+    Starts virtual time & sets default i2c clock
+*/
+/**************************************************************************/
+void SIMreset(uint64_t now)
+{
+  SIMnow = now;
+  SIMbusClock(SIM_BUS_CLOCK);
+}
+
+/**************************************************************************/
+/*
+    SIMbusClock()
+
+    Sets i2c clock, one byte takes 9 clocks
+*/
+/**************************************************************************/
+void SIMbusClock(uint32_t hz)
+{
+  SIMbyteTime = 9000000000ULL / hz;
+}
+
+/**************************************************************************/
+/*
+    SIMbusInit()
+
+    Empty bus
+*/
+/**************************************************************************/
+void SIMbusInit(sim_bus *bus)
+{
+  memset(bus, 0, sizeof(sim_bus));
+}
+
+/**************************************************************************/
+/*
+    SIMattach()
+
+    Connects & powers up device
+*/
+/**************************************************************************/
+void SIMattach(sim_bus *bus, sim_lcd *lcd, sim_chip chip, uint8_t address)
+{
+  memset(lcd, 0, sizeof(sim_lcd));
+
+  lcd->chip    = chip;
+  lcd->address = address;
+  lcd->present = true;
+
+  SIMpowerOn(lcd);
+
+  if (bus->count < SIM_MAX_DEVICES) bus->devices[bus->count++] = lcd;
+}
+
+/**************************************************************************/
+/*
+    SIMpowerOn()
+
+    Power-up state of chip & controller, e.g. after power loss
+
+    NOTE:
+    - PCF8574 outputs are high after power-up, MCP230xx pins are inputs
+    - DDRAM & CGRAM are random, controller is in 8-bit mode & busy with
+      internal reset for 40ms
+*/
+/**************************************************************************/
+void SIMpowerOn(sim_lcd *lcd)
+{
+  memset(lcd->registers, 0, sizeof(lcd->registers));
+  memset(lcd->ddram, '?', sizeof(lcd->ddram));
+  memset(lcd->cgram, 0xAA, sizeof(lcd->cgram));
+
+  lcd->registers[0x00] = 0xFF;                       //IODIR, IODIRA
+  lcd->registers[0x01] = (lcd->chip == SIM_MCP23017) ? 0xFF : 0x00; //IODIRB
+  lcd->pointer          = 0;
+  lcd->control          = true;
+  lcd->pins             = (lcd->chip == SIM_PCF8574) ? 0x0F : 0x00;
+  lcd->bus              = (lcd->chip == SIM_PCF8574) ? 0xFF : 0x00;
+  lcd->addressCounter   = 0x00;
+  lcd->cgramSelected    = false;
+  lcd->increment        = true;
+  lcd->shiftOnWrite     = false;
+  lcd->shift            = 0;
+  lcd->displayControl   = 0x00;
+  lcd->fourBit          = false;
+  lcd->twoLine          = false;
+  lcd->font5x10         = false;
+  lcd->instructionTable = false;
+  lcd->nibblePending    = false;
+  lcd->readLowNibble    = false;
+  lcd->resetStage       = 0;
+  lcd->busyUntil        = SIMnow + SIM_POWER_ON_TIME;
+  lcd->followerOn       = 0;
+}
+
+/**************************************************************************/
+/*
+    SIMrow()
+
+    Visible text of screen row, display shift included
+
+    NOTE:
+    - rows 2 & 3 of 4-row lcd continue lines 0 & 1 after "colums"
+    - text has to fit colums + 1 bytes
+*/
+/**************************************************************************/
+void SIMrow(const sim_lcd *lcd, uint8_t colums, uint8_t row, char *text)
+{
+  for (uint8_t colum = 0; colum < colums; colum++)
+  {
+    uint8_t address = 0;
+
+    if (lcd->twoLine == true) address = ((row & 0x01) * 0x40) + ((((row >> 1) * colums) + colum + lcd->shift) % 40);
+    else                      address = ((row * colums) + colum + lcd->shift) % 80;
+
+    text[colum] = lcd->ddram[address];
+  }
+
+  text[colums] = 0;
+}
+
+/**************************************************************************/
+/*
+    SIMglyph()
+
+    Returns CGRAM pattern shown by character code 0x00..0x07
+
+    NOTE:
+    - 5x8 glyph is 8 bytes, 5x10 glyph is 16 bytes apart & selected by
+      code bits 2..1, see Table 5 of HD44780 datasheet
+*/
+/**************************************************************************/
+const uint8_t *SIMglyph(const sim_lcd *lcd, uint8_t code)
+{
+  if (lcd->font5x10 == true) return &lcd->cgram[((code >> 1) & 0x03) << 4];
+
+  return &lcd->cgram[(code & 0x07) << 3];
+}
+
+/**************************************************************************/
+/*
+    SIMwrite()
+
+    i2c write, every byte takes 9 clocks, device reacts on ACK of every
+    byte same as real chip
+
+    NOTE:
+    - missing or unplugged device NACKs address, LCD_BUS_ERROR
+    - busyReplies answers LCD_BUS_BUSY without bus traffic
+*/
+/**************************************************************************/
+lcd_bus_status SIMwrite(void *handle, uint8_t address, const uint8_t *data, uint16_t length)
+{
+  sim_bus *bus     = (sim_bus *)handle;
+  sim_lcd *lcd     = NULL;
+  uint8_t  control = 0;
+
+  for (uint8_t i = 0; i < bus->count; i++)
+  {
+    if (bus->devices[i]->address == address) lcd = bus->devices[i];
+  }
+
+  if ((lcd != NULL) && (lcd->busyReplies > 0))
+  {
+    lcd->busyReplies--;
+    return LCD_BUS_BUSY;
+  }
+
+  bus->transactions++;
+  SIMnow += SIMbyteTime;                             //address byte
+
+  if ((lcd == NULL) || (lcd->present == false)) return LCD_BUS_ERROR;
+
+  lcd->control = true;                               //native transaction starts with control byte
+
+  for (uint16_t i = 0; i < length; i++)
+  {
+    SIMnow += SIMbyteTime;
+    bus->bytes++;
+
+    switch (lcd->chip)
+    {
+      case SIM_PCF8574:
+        SIMport(lcd, data[i]);
+        break;
+
+      case SIM_MCP23008:
+      case SIM_MCP23017:
+        if (i == 0) lcd->pointer = data[0];          //register address
+        else        SIMmcpWrite(lcd, data[i]);
+        break;
+
+      default:
+        SIMnativeWrite(lcd, data[i], &control);
+        break;
+    }
+  }
+
+  return LCD_BUS_OK;
+}
+
+/**************************************************************************/
+/*
+    SIMread()
+
+    i2c read of PCF8574 port
+
+    NOTE:
+    - pin written high is pulled low by lcd while RW=1 & E=1, see
+      Quasi-Bidirectional I/O of PCF8574 datasheet
+    - other chips return zeros, they are write only in the driver
+*/
+/**************************************************************************/
+lcd_bus_status SIMread(void *handle, uint8_t address, uint8_t *data, uint16_t length)
+{
+  sim_bus *bus = (sim_bus *)handle;
+  sim_lcd *lcd = NULL;
+
+  for (uint8_t i = 0; i < bus->count; i++)
+  {
+    if (bus->devices[i]->address == address) lcd = bus->devices[i];
+  }
+
+  if ((lcd != NULL) && (lcd->busyReplies > 0))
+  {
+    lcd->busyReplies--;
+    return LCD_BUS_BUSY;
+  }
+
+  bus->transactions++;
+  SIMnow += SIMbyteTime;
+
+  if ((lcd == NULL) || (lcd->present == false)) return LCD_BUS_ERROR;
+
+  for (uint16_t i = 0; i < length; i++)
+  {
+    uint8_t port = lcd->pins | (lcd->bus & 0xF0);
+
+    SIMnow += SIMbyteTime;
+    bus->bytes++;
+
+    if ((lcd->chip == SIM_PCF8574) && ((lcd->pins & (SIM_PIN_RW | SIM_PIN_E)) == (SIM_PIN_RW | SIM_PIN_E))) port &= (SIMreadBus(lcd) | 0x0F);
+
+    data[i] = (lcd->chip == SIM_PCF8574) ? port : 0x00;
+  }
+
+  return LCD_BUS_OK;
+}
+
+/**************************************************************************/
+/*
+    SIMdelay()
+
+    Blocking delay, moves virtual time, in microseconds
+*/
+/**************************************************************************/
+void SIMdelay(uint16_t delay)
+{
+  SIMnow += (uint64_t)delay * 1000;
+}
+
+/**************************************************************************/
+/*
+    SIMtimestamp()
+
+    Virtual time, in microseconds
+*/
+/**************************************************************************/
+uint32_t SIMtimestamp(void)
+{
+  return (uint32_t)(SIMnow / 1000);
+}
+
+/**************************************************************************/
+/*
+    SIMtimeElapsed()
+
+    Returns true if delay passed since timestamp, in microseconds
+
+    NOTE:
+    - every poll costs 1us of virtual time, so polling loops end
+*/
+/**************************************************************************/
+bool SIMtimeElapsed(uint32_t timestamp, uint16_t delay)
+{
+  if ((uint32_t)(SIMtimestamp() - timestamp) >= delay) return true;
+
+  SIMnow += 1000;
+
+  return false;
+}
+
+/**************************************************************************/
+/*
+    SIMuptime()
+
+    Virtual time since MCU & lcd power-up, in milliseconds
+*/
+/**************************************************************************/
+uint32_t SIMuptime(void)
+{
+  return (uint32_t)(SIMnow / 1000000);
+}
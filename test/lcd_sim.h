@@ -0,0 +1,113 @@
+/***************************************************************************************************/
+/*
+   Host simulator of i2c lcd backpacks for LiquidCrystal_I2C library tests & benchmarks.
+
+   Models PCF8574, MCP23008 & MCP23017 expanders wired to HD44780, & ST7032/AiP31068 controllers
+   with built-in i2c. Controller decodes nibbles/bytes into DDRAM & CGRAM, tracks address counter,
+   display shift & busy flag, & counts every instruction that breaks datasheet timing.
+
+   Time is virtual, i2c bytes & driver delays move the clock, see SIMbusClock().
+
+   written by : enjoyneering79, edited by Jojo-A
+   sourse code: https://github.com/enjoyneering/
+
+   GNU GPL license, all text above must be included in any redistribution,
+   see link for details  - https://www.gnu.org/licenses/licenses.html
+*/
+/***************************************************************************************************/
+
+#ifndef LCD_SIM_h
+#define LCD_SIM_h
+
+#include "LiquidCrystal_I2C.h"
+
+#define SIM_MAX_DEVICES        8             //devices on one simulated bus
+#define SIM_BUS_CLOCK          400000        //default i2c clock, in Hz
+#define SIM_POWER_ON_TIME      40000000      //HD44780 & ST7032 power-on reset, in nanoseconds
+#define SIM_FIRST_RESET_TIME   4100000       //first function set after power-on, in nanoseconds
+#define SIM_SECOND_RESET_TIME  100000        //second function set after power-on, in nanoseconds
+#define SIM_FOLLOWER_TIME      200000000     //ST7032 voltage follower settle time, in nanoseconds
+
+
+typedef enum : uint8_t
+{
+  SIM_PCF8574                  = 0x00,       //HD44780 behind PCF8574, 4-bit, standard backpack wiring
+  SIM_MCP23008                 = 0x01,       //HD44780 behind MCP23008, same wiring as PCF8574
+  SIM_MCP23017                 = 0x02,       //HD44780 behind MCP23017, port A RS,RW,E,BCK_LED, port B DB7..DB0
+  SIM_ST7032                   = 0x03,       //native i2c controller, 26.3us commands
+  SIM_AIP31068                 = 0x04        //native i2c controller, 43us commands
+}
+sim_chip;
+
+typedef struct
+{
+  /* i2c chip */
+  sim_chip chip;
+  uint8_t  address;                          //7-bit
+  bool     present;                          //false - chip NACKs, e.g. unplugged
+  uint32_t busyReplies;                      //next transactions answered with LCD_BUS_BUSY
+  uint8_t  registers[0x16];                  //MCP230xx registers, IOCON.BANK=0 layout
+  uint8_t  pointer;                          //MCP230xx register pointer
+  bool     control;                          //native controller expects control byte
+
+  /* lcd pins */
+  uint8_t  pins;                             //RS,RW,E,BCK_LED as PCF8574 P0..P3
+  uint8_t  bus;                              //DB7..DB0
+
+  /* controller */
+  uint8_t  ddram[128];
+  uint8_t  cgram[64];
+  uint8_t  addressCounter;
+  bool     cgramSelected;
+  bool     increment;                        //entry mode I/D
+  bool     shiftOnWrite;                     //entry mode S
+  uint8_t  shift;                            //display shift, first visible DDRAM colum of line
+  uint8_t  displayControl;                   //D,C,B
+  bool     fourBit;
+  bool     twoLine;
+  bool     font5x10;
+  bool     instructionTable;                 //ST7032 IS bit
+  bool     nibblePending;                    //high nibble of 4-bit transfer is latched
+  uint8_t  nibble;
+  bool     readLowNibble;                    //next 4-bit read returns AC3..AC0
+  uint8_t  resetStage;                       //function sets since power-on
+  uint64_t busyUntil;                        //virtual time, in nanoseconds
+  uint64_t followerOn;                       //ST7032 follower switched on, 0 - off
+
+  /* counters */
+  uint32_t instructions;
+  uint32_t writes;                           //DDRAM & CGRAM data writes
+  uint32_t violations;                       //instructions sent while controller is busy or data not stable
+  const char *lastViolation;
+}
+sim_lcd;
+
+typedef struct
+{
+  sim_lcd *devices[SIM_MAX_DEVICES];
+  uint8_t  count;
+  uint32_t transactions;
+  uint32_t bytes;                            //address bytes not included
+}
+sim_bus;
+
+extern const lcd_bus SIMbusBackend;          //handle is sim_bus
+extern uint64_t      SIMnow;                 //virtual time, in nanoseconds
+
+
+void           SIMreset(uint64_t now = 0);
+void           SIMbusClock(uint32_t hz);
+void           SIMbusInit(sim_bus *bus);
+void           SIMattach(sim_bus *bus, sim_lcd *lcd, sim_chip chip, uint8_t address);
+void           SIMpowerOn(sim_lcd *lcd);
+void           SIMrow(const sim_lcd *lcd, uint8_t colums, uint8_t row, char *text);
+const uint8_t *SIMglyph(const sim_lcd *lcd, uint8_t code);
+
+lcd_bus_status SIMwrite(void *handle, uint8_t address, const uint8_t *data, uint16_t length);
+lcd_bus_status SIMread(void *handle, uint8_t address, uint8_t *data, uint16_t length);
+void           SIMdelay(uint16_t delay);
+uint32_t       SIMtimestamp(void);
+bool           SIMtimeElapsed(uint32_t timestamp, uint16_t delay);
+uint32_t       SIMuptime(void);
+
+#endif
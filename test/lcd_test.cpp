@@ -0,0 +1,1229 @@
+/***************************************************************************************************/
+/*
+   Behavior tests of LiquidCrystal_I2C library on host simulator, see lcd_sim.h
+
+   Usage: lcd_test [test name], runs all tests without name
+
+   written by : enjoyneering79, edited by Jojo-A
+   sourse code: https://github.com/enjoyneering/
+
+   GNU GPL license, all text above must be included in any redistribution,
+   see link for details  - https://www.gnu.org/licenses/licenses.html
+*/
+/***************************************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "lcd_sim.h"
+#include "LiquidCrystal_I2C.hpp"
+#include "I2C_Scheduler.h"
+
+#define CHECK(condition)     checkResult((condition), #condition, __LINE__)
+#define CHECK_ROW(row, text) CHECK(rowEquals((row), (text)))
+#define TRACE_SIZE           4096                    //bytes of traced i2c writes
+#define ASYNC_LOG_SIZE       64                      //logged transfers of scheduler test
+
+static uint32_t          failures = 0;
+static sim_bus           bus;
+static sim_lcd           sim;
+static LiquidCrystal_I2C lcd;
+static uint8_t           colums   = 0;
+
+
+/**************************************************************************/
+/*
+    checkResult()
+
+    Prints failed check & counts it
+*/
+/**************************************************************************/
+static void checkResult(bool passed, const char *condition, int line)
+{
+  if (passed == true) return;
+
+  printf("  line %d: CHECK(%s) failed\n", line, condition);
+  failures++;
+}
+
+/**************************************************************************/
+/*
+    rowEquals()
+
+    Compares visible row of simulated lcd, text is padded with spaces
+*/
+/**************************************************************************/
+static bool rowEquals(uint8_t row, const char *text)
+{
+  char visible[LCD_DDRAM_LINE_SIZE * 2 + 1] = {0};
+  char wanted[LCD_DDRAM_LINE_SIZE * 2 + 1]  = {0};
+
+  SIMrow(&sim, colums, row, visible);
+
+  memset(wanted, ' ', colums);
+  memcpy(wanted, text, strlen(text));
+
+  if (strcmp(visible, wanted) == 0) return true;
+
+  printf("  row %u: \"%s\", wanted \"%s\"\n", row, visible, wanted);
+  return false;
+}
+
+/**************************************************************************/
+/*
+    start()
+
+    Powers up simulated chip & begins lcd on it, virtual time starts at
+    MCU power-up
+*/
+/**************************************************************************/
+static bool start(sim_chip chip, const lcd_backend *backend, uint8_t lcd_colums, uint8_t lcd_rows, lcd_font_size f_size = LCD_5x8DOTS)
+{
+  bool            native  = (chip == SIM_ST7032) || (chip == SIM_AIP31068);
+  PCF8574_address address = (native == true) ? LCD_NATIVE_ADDR : PCF8574_ADDR_A21_A11_A01;
+
+  SIMreset();
+  SIMbusInit(&bus);
+  SIMattach(&bus, &sim, chip, address);
+
+  colums = lcd_colums;
+
+  LCDinitBus(&lcd, &SIMbusBackend, &bus, address);
+  LCDbackend(&lcd, backend);
+
+  return LCDbegin(&lcd, lcd_colums, lcd_rows, f_size);
+}
+
+/**************************************************************************/
+/*
+    transactions()
+
+    i2c transactions of lcd since last LCDresetStatistics()
+*/
+/**************************************************************************/
+static uint32_t transactions(void)
+{
+  lcd_statistics stats;
+
+  LCDstatistics(&lcd, &stats);
+
+  return stats.transactions;
+}
+
+/**************************************************************************/
+/*
+    linkRestore()
+
+    Calls LCDlinkService() every millisecond until display responds,
+    returns the longest call, in nanoseconds, 0 if display is not restored
+*/
+/**************************************************************************/
+static uint64_t linkRestore(void)
+{
+  uint64_t longest = 0;
+  uint64_t begin   = 0;
+  bool     up      = false;
+
+  for (uint16_t i = 0; i < 2000; i++)
+  {
+    begin = SIMnow;
+    up    = LCDlinkService(&lcd, SIMuptime());
+
+    if ((SIMnow - begin) > longest) longest = SIMnow - begin;
+
+    if (up == true) return longest;
+
+    SIMdelay(1000);
+  }
+
+  return 0;
+}
+
+/**************************************************************************/
+/*
+    testInit()
+
+    Soft reset, 4-bit interface, power-on wait & lcd modes after LCDbegin()
+*/
+/**************************************************************************/
+static void testInit(void)
+{
+  uint64_t begin = 0;
+
+  CHECK(start(SIM_PCF8574, &LCDbackendPCF8574, 20, 4) == true);
+
+  CHECK(sim.violations     == 0);
+  CHECK(sim.resetStage     == 2);                    //power-on reset by instruction
+  CHECK(sim.fourBit        == true);
+  CHECK(sim.twoLine        == true);
+  CHECK(sim.font5x10       == false);
+  CHECK(sim.displayControl == 0x04);                 //display on, cursor off, blink off
+  CHECK(sim.increment      == true);
+  CHECK(sim.shiftOnWrite   == false);
+  CHECK(sim.addressCounter == 0x00);
+  CHECK(SIMnow             >= SIM_POWER_ON_TIME);
+
+  for (uint8_t row = 0; row < 4; row++) CHECK_ROW(row, "");
+
+  /* MCU restart long after lcd power-up skips power-on wait */
+  SIMreset(1000000000);
+  SIMbusInit(&bus);
+  SIMattach(&bus, &sim, SIM_PCF8574, PCF8574_ADDR_A21_A11_A01);
+  SIMnow = 2000000000;
+
+  begin = SIMnow;
+
+  LCDinitBus(&lcd, &SIMbusBackend, &bus);
+  CHECK(LCDbegin(&lcd, 16, 2) == true);
+  CHECK(sim.violations      == 0);
+  CHECK((SIMnow - begin)    <  10000000);
+
+  /* warm restart, lcd is in 4-bit mode already */
+  LCDprint(&lcd, "old");
+
+  begin = SIMnow;
+
+  LCDinitBus(&lcd, &SIMbusBackend, &bus);
+  CHECK(LCDbeginWarm(&lcd, 16, 2) == true);
+  CHECK(sim.violations      == 0);
+  CHECK((SIMnow - begin)    <  5000000);
+
+  colums = 16;
+  CHECK_ROW(0, "");
+}
+
+/**************************************************************************/
+/*
+    testPrint()
+
+    Text lands in DDRAM of the right rows, wrap follows row addresses
+*/
+/**************************************************************************/
+static void testPrint(void)
+{
+  start(SIM_PCF8574, &LCDbackendPCF8574, 20, 4);
+
+  LCDprint(&lcd, "Hello");
+  LCDsetCursor(&lcd, 3, 1);
+  LCDprint(&lcd, "world");
+  LCDsetCursor(&lcd, 0, 3);
+  LCDprintInt(&lcd, -42, 5);
+
+  CHECK_ROW(0, "Hello");
+  CHECK_ROW(1, "   world");
+  CHECK_ROW(2, "");
+  CHECK_ROW(3, "  -42");
+
+  /* 20x4 row 0 continues in DDRAM of row 2, LCDprintWrap() jumps to row 1 */
+  LCDclear(&lcd);
+  LCDprintWrap(&lcd, 15, 0, "0123456789\nabc");
+
+  CHECK_ROW(0, "               01234");
+  CHECK_ROW(1, "56789");
+  CHECK_ROW(2, "abc");
+  CHECK_ROW(3, "");
+
+  LCDprintWrap(&lcd, 18, 3, "xyz");
+
+  CHECK_ROW(3, "                  xy");
+  CHECK_ROW(0, "z              01234");
+
+  CHECK(sim.violations == 0);
+}
+
+/**************************************************************************/
+/*
+    testCursor()
+
+    LCDsetCursor() skips command if address counter is already there
+*/
+/**************************************************************************/
+static void testCursor(void)
+{
+  uint8_t position = 0;
+
+  start(SIM_PCF8574, &LCDbackendPCF8574, 16, 2);
+
+  LCDsetCursor(&lcd, 3, 1);
+  LCDprint(&lcd, "ab");
+
+  LCDresetStatistics(&lcd);
+  LCDsetCursor(&lcd, 5, 1);                          //address counter is there after "ab"
+  CHECK(transactions() == 0);
+
+  LCDsetCursor(&lcd, 0, 0);
+  CHECK(transactions() == 1);
+  CHECK(sim.addressCounter == 0x00);
+
+  LCDsetCursor(&lcd, 5, 1);
+  LCDprint(&lcd, "c");
+  CHECK_ROW(1, "   abc");
+
+  /* right to left text moves address counter backwards */
+  LCDrightToLeft(&lcd);
+  LCDsetCursor(&lcd, 10, 0);
+  LCDprint(&lcd, "xy");
+
+  LCDresetStatistics(&lcd);
+  LCDsetCursor(&lcd, 8, 0);
+  CHECK(transactions() == 0);
+  CHECK_ROW(0, "         yx");
+
+  /* busy flag read resyncs address counter */
+  LCDleftToRight(&lcd);
+  LCDsetCursor(&lcd, 7, 1);
+  position = LCDgetCursorPosition(&lcd);
+  CHECK(position == 0x47);
+  CHECK(position == sim.addressCounter);
+
+  CHECK(sim.violations == 0);
+}
+
+/**************************************************************************/
+/*
+    testFrameBuffer()
+
+    LCDflush() sends only changed runs of cells
+*/
+/**************************************************************************/
+static void testFrameBuffer(void)
+{
+  lcd_statistics stats;
+
+  start(SIM_PCF8574, &LCDbackendPCF8574, 20, 4);
+
+  CHECK(LCDframeBuffer(&lcd) == true);
+
+  LCDsetCursor(&lcd, 0, 0);
+  LCDprint(&lcd, "Temperature  21.5");
+  LCDsetCursor(&lcd, 0, 3);
+  LCDprint(&lcd, "Humidity     40");
+
+  CHECK_ROW(0, "");                                  //nothing is sent before flush
+
+  CHECK(LCDflush(&lcd) == true);
+  CHECK_ROW(0, "Temperature  21.5");
+  CHECK_ROW(3, "Humidity     40");
+
+  /* one changed cell, one cursor set & one character */
+  LCDresetStatistics(&lcd);
+  LCDsetCursor(&lcd, 16, 0);
+  LCDprint(&lcd, "6");
+  CHECK(LCDflush(&lcd) == true);
+
+  LCDstatistics(&lcd, &stats);
+  CHECK(stats.bytes <= 8);
+  CHECK_ROW(0, "Temperature  21.6");
+
+  /* nothing changed, nothing sent */
+  LCDresetStatistics(&lcd);
+  LCDsetCursor(&lcd, 0, 0);
+  LCDprint(&lcd, "Temp");
+  CHECK(LCDflush(&lcd) == true);
+  CHECK(transactions() == 0);
+
+  CHECK(sim.violations == 0);
+}
+
+/**************************************************************************/
+/*
+    testBudget()
+
+    LCDflushBudget() fills budget with bytes of the backend, not with
+    fixed PCF8574 cost
+*/
+/**************************************************************************/
+static void testBudget(void)
+{
+  const sim_chip     chips[]    = {SIM_PCF8574, SIM_MCP23008, SIM_ST7032};
+  const lcd_backend *backends[] = {&LCDbackendPCF8574, &LCDbackendMCP23008, &LCDbackendST7032};
+  lcd_statistics     stats;
+  uint8_t            calls      = 0;
+  bool               done       = false;
+
+  for (uint8_t i = 0; i < 3; i++)
+  {
+    start(chips[i], backends[i], 20, 4);
+    LCDframeBuffer(&lcd);
+
+    for (uint8_t row = 0; row < 4; row++)
+    {
+      LCDsetCursor(&lcd, 0, row);
+      LCDprint(&lcd, "0123456789abcdefghij");
+    }
+
+    for (calls = 0, done = false; (done == false) && (calls < 50); calls++)
+    {
+      LCDresetStatistics(&lcd);
+      done = LCDflushBudget(&lcd, 32);
+      LCDstatistics(&lcd, &stats);
+
+      CHECK(stats.bytes <= (32 + backends[i]->prefixLength));
+      CHECK((done == true) || (stats.bytes >= (32 - 8)));        //budget is used, next cell didn't fit
+    }
+
+    CHECK(done == true);
+    CHECK_ROW(0, "0123456789abcdefghij");
+    CHECK_ROW(3, "0123456789abcdefghij");
+    CHECK(sim.violations == 0);
+
+    if (chips[i] == SIM_ST7032) CHECK(calls <= 6); //4 rows * (2 + 2 + 19 * 2) bytes
+    else                        CHECK(calls >= 11); //4 rows * (8 + 19 * 4) bytes
+  }
+}
+
+/**************************************************************************/
+/*
+    testCgram()
+
+    Custom characters land in CGRAM slot & text continues in DDRAM
+*/
+/**************************************************************************/
+static void testCgram(void)
+{
+  const uint8_t heart[8] = {0x00, 0x0A, 0x1F, 0x1F, 0x0E, 0x04, 0x00, 0x00};
+  const uint8_t arrow[8] = {0x04, 0x0E, 0x15, 0x04, 0x04, 0x04, 0x04, 0x00};
+  uint8_t       code     = 0;
+
+  start(SIM_PCF8574, &LCDbackendPCF8574, 16, 2);
+
+  LCDsetCursor(&lcd, 0, 1);
+  LCDprint(&lcd, "ab");
+  LCDcreateChar(&lcd, 3, heart);
+  CHECK(memcmp(SIMglyph(&sim, 3), heart, 8) == 0);
+
+  LCDwrite(&lcd, 3);                                 //CGRAM address set, cursor has to be set again
+  CHECK(sim.ddram[0x42] != 0x03);
+  LCDsetCursor(&lcd, 2, 1);
+  LCDwrite(&lcd, 3);
+  LCDprint(&lcd, "c");
+  CHECK_ROW(1, "ab\x03" "c");
+
+  /* glyph cache */
+  LCDglyphCache(&lcd, 4, 4);
+  code = LCDglyph(&lcd, arrow);
+  CHECK((code >= 4) && (code < 8));
+  CHECK(memcmp(SIMglyph(&sim, code), arrow, 8) == 0);
+
+  LCDresetStatistics(&lcd);
+  CHECK(LCDglyph(&lcd, arrow) == code);              //cache hit, no upload
+  CHECK(transactions()        == 0);
+  CHECK(memcmp(SIMglyph(&sim, 3), heart, 8) == 0);
+
+  CHECK(sim.violations == 0);
+}
+
+/**************************************************************************/
+/*
+    testCgram5x10()
+
+    5x10 glyphs take 16-byte CGRAM slots & are shown by code slot * 2,
+    bars, glyph cache & link restore use the same layout
+*/
+/**************************************************************************/
+static void testCgram5x10(void)
+{
+  uint8_t patterns[4 * 10] = {0};
+  uint8_t pattern[10]      = {0x1F, 0x00, 0x1F, 0x00, 0x1F, 0x00, 0x1F, 0x00, 0x1F, 0x00};
+  lcd_bar bar;
+  uint8_t code             = 0;
+
+  for (uint8_t i = 0; i < sizeof(patterns); i++) patterns[i] = i + 1;
+
+  CHECK(start(SIM_PCF8574, &LCDbackendPCF8574, 16, 1, LCD_5x10DOTS) == true);
+  CHECK(sim.font5x10 == true);
+  CHECK(sim.twoLine  == false);
+
+  LCDcreateChars(&lcd, 0, 4, patterns);
+
+  for (uint8_t slot = 0; slot < 4; slot++)
+  {
+    CHECK(memcmp(SIMglyph(&sim, LCDglyphCode(&lcd, slot)), &patterns[slot * 10], 10) == 0);
+    CHECK(memcmp(&sim.cgram[slot << 4], &patterns[slot * 10], 10) == 0);
+  }
+
+  /* horizontal bar, 16 cells * 5 steps, level 12 is 2 full cells & 2 pixel colums */
+  CHECK(LCDbarGlyphs(&lcd, LCD_BAR_HORIZONTAL, 0) == true);
+  LCDbarInit(&lcd, &bar, 0, 0, 16, LCD_BAR_HORIZONTAL, 0);
+  LCDbarDraw(&lcd, &bar, 12, 80);
+
+  CHECK(sim.ddram[0] == 0xFF);
+  CHECK(sim.ddram[1] == 0xFF);
+  CHECK(sim.ddram[3] == 0x20);
+  CHECK(SIMglyph(&sim, sim.ddram[2])[0] == 0x18);
+  CHECK(SIMglyph(&sim, sim.ddram[2])[9] == 0x18);
+
+  /* glyph cache in the last slot */
+  LCDglyphCache(&lcd, 3, 1);
+  code = LCDglyph(&lcd, pattern);
+  CHECK(code == 6);
+  CHECK(memcmp(SIMglyph(&sim, code), pattern, 10) == 0);
+
+  /* link restore puts every slot back to its place */
+  sim.present = false;
+  LCDclear(&lcd);
+  sim.present = true;
+  SIMpowerOn(&sim);
+
+  CHECK(linkRestore() != 0);
+  CHECK(SIMglyph(&sim, LCDglyphCode(&lcd, 0))[0] == 0x10);
+  CHECK(memcmp(SIMglyph(&sim, code), pattern, 10) == 0);
+
+  CHECK(sim.violations == 0);
+}
+
+/**************************************************************************/
+/*
+    marqueeMatches()
+
+    Runs marquee for steps & compares visible row with looping text
+    after every step
+*/
+/**************************************************************************/
+static bool marqueeMatches(uint8_t row, const char *text, uint16_t steps)
+{
+  lcd_marquee marquee;
+  char        visible[LCD_DDRAM_1LINE_SIZE + 1] = {0};
+
+  LCDmarqueeInit(&lcd, &marquee, row, text);
+
+  for (uint16_t step = 0; step <= steps; step++)
+  {
+    SIMrow(&sim, colums, row, visible);
+
+    for (uint8_t colum = 0; colum < colums; colum++)
+    {
+      uint16_t index  = (step + colum) % marquee.period;
+      char     wanted = (index < marquee.length) ? text[index] : ' ';
+
+      if (visible[colum] == wanted) continue;
+
+      printf("  step %u: \"%s\", colum %u wanted '%c'\n", step, visible, colum, wanted);
+      return false;
+    }
+
+    LCDmarqueeStep(&lcd, &marquee);
+  }
+
+  return true;
+}
+
+/**************************************************************************/
+/*
+    testMarquee()
+
+    Display shift & marquee wrap at 40 bytes line in 2-line mode & at
+    80 bytes line in 1-line mode
+*/
+/**************************************************************************/
+static void testMarquee(void)
+{
+  const char *shortText = "Short marquee text, 30 chars..";
+  const char *longText  = "Long marquee text streams into hidden part of DDRAM line while it scrolls, 103 characters in total....";
+
+  start(SIM_PCF8574, &LCDbackendPCF8574, 16, 1);
+
+  for (uint8_t i = 0; i < 85; i++) LCDscrollDisplayLeft(&lcd);
+  CHECK(lcd._displayShift == 5);
+  CHECK(sim.shift         == 5);
+
+  for (uint8_t i = 0; i < 6; i++) LCDscrollDisplayRight(&lcd);
+  CHECK(lcd._displayShift == 79);
+  CHECK(sim.shift         == 79);
+
+  LCDhome(&lcd);
+  CHECK(marqueeMatches(0, shortText, 200));
+
+  LCDclear(&lcd);
+  CHECK(marqueeMatches(0, longText, 250));
+
+  start(SIM_PCF8574, &LCDbackendPCF8574, 20, 2);
+
+  LCDscrollDisplayRight(&lcd);
+  CHECK(lcd._displayShift == 39);
+  CHECK(sim.shift         == 39);
+
+  LCDhome(&lcd);
+  CHECK(marqueeMatches(1, shortText, 100));
+
+  LCDclear(&lcd);
+  CHECK(marqueeMatches(1, longText, 250));
+
+  CHECK(sim.violations == 0);
+}
+
+/**************************************************************************/
+/*
+    testAutoscroll()
+
+    Data write with S=1 shifts display in I/D direction, software copy
+    of display shift follows lcd, so marquee starts in the right place
+*/
+/**************************************************************************/
+static void testAutoscroll(void)
+{
+  start(SIM_PCF8574, &LCDbackendPCF8574, 16, 2);
+
+  LCDsetCursor(&lcd, 15, 0);
+  LCDautoscroll(&lcd);
+  LCDprint(&lcd, "abcd");
+  CHECK(sim.shift         == 4);
+  CHECK(lcd._displayShift == sim.shift);
+  CHECK_ROW(0, "           abcd");
+
+  LCDrightToLeft(&lcd);
+  LCDprint(&lcd, "xy");
+  CHECK(sim.shift         == 2);
+  CHECK(lcd._displayShift == sim.shift);
+
+  LCDleftToRight(&lcd);
+  LCDscrollDisplayRight(&lcd);
+  LCDscrollDisplayRight(&lcd);
+  LCDscrollDisplayRight(&lcd);
+  CHECK(sim.shift         == 39);
+  CHECK(lcd._displayShift == sim.shift);
+
+  /* CGRAM write doesn't shift */
+  LCDcreateChar(&lcd, 0, (const uint8_t *)"\x01\x02\x03\x04\x05\x06\x07\x08");
+  CHECK(sim.shift         == 39);
+  CHECK(lcd._displayShift == sim.shift);
+
+  LCDnoAutoscroll(&lcd);
+  CHECK(marqueeMatches(1, "marquee after autoscroll", 60));
+  CHECK(lcd._displayShift == sim.shift);
+
+  LCDclear(&lcd);
+  CHECK(sim.shift         == 0);
+  CHECK(lcd._displayShift == 0);
+
+  CHECK(sim.violations == 0);
+}
+
+/**************************************************************************/
+/*
+    testLink()
+
+    Circuit breaker opens on unplugged display & LCDlinkService()
+    restores text, custom characters & modes after power loss, restore
+    waits for power-on reset & ST7032 follower without long calls
+*/
+/**************************************************************************/
+static void testLink(void)
+{
+  const uint8_t bell[8] = {0x04, 0x0E, 0x0E, 0x0E, 0x1F, 0x00, 0x04, 0x00};
+  uint32_t      calls   = 0;
+  uint64_t      longest = 0;
+
+  start(SIM_PCF8574, &LCDbackendPCF8574, 20, 4);
+
+  LCDcreateChar(&lcd, 2, bell);
+  LCDsetCursor(&lcd, 0, 0);
+  LCDprint(&lcd, "Hello world");
+  LCDsetCursor(&lcd, 2, 2);
+  LCDwrite(&lcd, 2);
+  LCDblink(&lcd);
+
+  /* unplugged, lcd looses power */
+  sim.present = false;
+  SIMpowerOn(&sim);
+
+  LCDsetCursor(&lcd, 0, 1);
+  LCDprint(&lcd, "during fault");
+  CHECK(LCDconnected(&lcd) == false);
+
+  calls = bus.transactions;
+  LCDsetCursor(&lcd, 5, 3);
+  LCDprint(&lcd, "abc");
+  CHECK(bus.transactions == calls);                  //breaker is open, no bus traffic
+
+  CHECK(LCDlinkService(&lcd, SIMuptime()) == false);
+
+  /* plugged back right before the next probe */
+  for (uint16_t i = 0; i < LCD_LINK_RETRY_PERIOD; i++) SIMdelay(1000);
+
+  sim.present = true;
+  SIMpowerOn(&sim);                                  //lcd is in power-on reset right after probe
+
+  longest = linkRestore();
+  CHECK(longest            >  0);
+  CHECK(longest            <  20000000);             //CGRAM & screen restore, ~15ms @ 400kHz
+  CHECK(LCDconnected(&lcd) == true);
+
+  CHECK_ROW(0, "Hello world");
+  CHECK_ROW(1, "during fault");
+  CHECK_ROW(2, "  \x02");
+  CHECK_ROW(3, "     abc");
+  CHECK(memcmp(SIMglyph(&sim, 2), bell, 8) == 0);
+  CHECK(sim.displayControl == 0x05);                 //display on, blink on
+  CHECK(sim.fourBit        == true);
+
+  LCDprint(&lcd, "X");                               //cursor is restored too
+  CHECK_ROW(3, "     abcX");
+
+  CHECK(sim.violations == 0);
+
+  /* ST7032 follower settles between calls */
+  start(SIM_ST7032, &LCDbackendST7032, 16, 2);
+
+  LCDprint(&lcd, "native");
+
+  sim.present = false;
+  LCDsetCursor(&lcd, 0, 1);
+  LCDprint(&lcd, "restored");
+  CHECK(LCDconnected(&lcd) == false);
+
+  for (uint16_t i = 0; i < LCD_LINK_RETRY_PERIOD; i++) SIMdelay(1000);
+
+  sim.present = true;
+  SIMpowerOn(&sim);
+
+  longest = linkRestore();
+  CHECK(longest        >  0);
+  CHECK(longest        <  20000000);                 //no 200ms follower wait in one call
+  CHECK(sim.followerOn != 0);
+  CHECK(sim.displayControl == 0x04);
+  CHECK_ROW(0, "native");
+  CHECK_ROW(1, "restored");
+
+  CHECK(sim.violations == 0);
+}
+
+/**************************************************************************/
+/*
+    testBusy()
+
+    Bus used by other device is waited for & never opens circuit breaker,
+    only NACK does, commands dropped on busy bus are not skipped later
+*/
+/**************************************************************************/
+static void testBusy(void)
+{
+  uint8_t value = 0;
+
+  start(SIM_PCF8574, &LCDbackendPCF8574, 16, 2);
+
+  sim.busyReplies = 50;
+  LCDprint(&lcd, "shared");
+  CHECK(sim.busyReplies       == 0);
+  CHECK(LCDconnected(&lcd)    == true);
+  CHECK_ROW(0, "shared");
+
+  sim.busyReplies = 50;
+  CHECK(readPCF8574(&lcd, &value) == true);
+  CHECK(LCDconnected(&lcd)    == true);
+
+  /* bus stays busy, commands are dropped, link is still up & nothing is skipped later */
+  sim.busyReplies = 1000000;
+  LCDsetCursor(&lcd, 0, 1);
+  LCDblink(&lcd);
+  CHECK(LCDconnected(&lcd)    == true);
+  CHECK(LCDlinkService(&lcd, SIMuptime()) == true);
+  CHECK(sim.displayControl    == 0x04);
+
+  sim.busyReplies = 0;
+  LCDsetCursor(&lcd, 0, 1);
+  LCDprint(&lcd, "X");
+  CHECK_ROW(0, "shared");
+  CHECK_ROW(1, "X");
+  CHECK(sim.displayControl    == 0x05);                 //dropped blink is sent again
+
+  /* dropped flush, next flush sends the whole frame */
+  LCDframeBuffer(&lcd);
+  LCDprint(&lcd, "frame");
+  sim.busyReplies = 1000000;
+  CHECK(LCDflush(&lcd)        == false);
+  sim.busyReplies = 0;
+  LCDsetCursor(&lcd, 0, 1);
+  LCDprint(&lcd, "bus");
+  CHECK(LCDflush(&lcd)        == true);
+  CHECK_ROW(0, "frame");
+  CHECK_ROW(1, "bus");
+
+  /* NACK opens it */
+  sim.present = false;
+  LCDprint(&lcd, "x");
+  CHECK(LCDflush(&lcd)        == false);
+  CHECK(LCDconnected(&lcd)    == false);
+
+  CHECK(sim.violations == 0);
+}
+
+/**************************************************************************/
+/*
+    testTiming()
+
+    No instruction reaches busy lcd in direct, batch & busy flag modes,
+    simulator catches too fast bus
+*/
+/**************************************************************************/
+static void testTiming(void)
+{
+  const uint8_t pattern[8] = {0x1F, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x1F};
+
+  start(SIM_PCF8574, &LCDbackendPCF8574, 20, 4);
+
+  for (uint8_t row = 0; row < 4; row++)
+  {
+    LCDsetCursor(&lcd, 0, row);
+    LCDprint(&lcd, "01234567890123456789");
+  }
+
+  LCDcreateChar(&lcd, 0, pattern);
+  LCDclear(&lcd);
+  LCDhome(&lcd);
+  LCDprintHorizontalGraph(&lcd, 'A', 1, 50, 100);
+  LCDscrollDisplayLeft(&lcd);
+  LCDcursor(&lcd);
+  CHECK(sim.violations == 0);
+
+  /* busy flag polling */
+  LCDbusyFlagPolling(&lcd);
+  LCDclear(&lcd);
+  LCDprint(&lcd, "polled");
+  LCDhome(&lcd);
+  CHECK(sim.violations == 0);
+  CHECK_ROW(0, "polled");
+
+  /* batch mode relies on <= 400kHz, 2 bytes per 37us command */
+  SIMbusClock(1000000);
+  LCDsetCursor(&lcd, 0, 1);
+  LCDprint(&lcd, "too fast");
+  CHECK(sim.violations > 0);
+}
+
+/**************************************************************************/
+/*
+    testBackends()
+
+    Same text through every interface chip, native controllers get data
+    no faster than they execute it @ 400kHz
+*/
+/**************************************************************************/
+static void testBackends(void)
+{
+  const sim_chip     chips[]    = {SIM_MCP23008, SIM_MCP23017, SIM_ST7032, SIM_AIP31068};
+  const lcd_backend *backends[] = {&LCDbackendMCP23008, &LCDbackendMCP23017, &LCDbackendST7032, &LCDbackendAiP31068};
+
+  for (uint8_t i = 0; i < 4; i++)
+  {
+    CHECK(start(chips[i], backends[i], 16, 2) == true);
+
+    LCDprint(&lcd, "backend");
+    LCDsetCursor(&lcd, 4, 1);
+    LCDprint(&lcd, "chip");
+    LCDcursor(&lcd);
+
+    CHECK_ROW(0, "backend");
+    CHECK_ROW(1, "    chip");
+    CHECK(sim.displayControl == 0x06);
+    CHECK(sim.twoLine        == true);
+
+    /* long text & custom characters in one batch */
+    LCDclear(&lcd);
+    LCDcreateChar(&lcd, 1, (const uint8_t *)"\x1F\x11\x11\x11\x11\x11\x11\x1F");
+    LCDbeginBatch(&lcd);
+    LCDsetCursor(&lcd, 0, 0);
+    LCDprint(&lcd, "0123456789abcdef");
+    LCDsetCursor(&lcd, 0, 1);
+    LCDwrite(&lcd, 1);
+    LCDprint(&lcd, "123456789abcde");
+    LCDwrite(&lcd, 1);
+    LCDendBatch(&lcd);
+
+    CHECK_ROW(0, "0123456789abcdef");
+    CHECK_ROW(1, "\x01" "123456789abcde" "\x01");
+    CHECK(sim.violations == 0);
+  }
+}
+
+/**************************************************************************/
+/*
+    traceWrite()
+
+    Simulator write that keeps copy of every written byte, see testTemplate()
+*/
+/**************************************************************************/
+static uint8_t  trace[TRACE_SIZE];
+static uint16_t traceLength = 0;
+
+static lcd_bus_status traceWrite(void *handle, uint8_t address, const uint8_t *data, uint16_t length)
+{
+  for (uint16_t i = 0; (i < length) && (traceLength < TRACE_SIZE); i++) trace[traceLength++] = data[i];
+
+  return SIMwrite(handle, address, data, length);
+}
+
+static const lcd_bus traceBus = {traceWrite, SIMread, NULL, SIMdelay, SIMtimestamp, SIMtimeElapsed, SIMuptime};
+
+/**************************************************************************/
+/*
+    traceStart()
+
+    Powers up simulated PCF8574 backpack & empties trace
+*/
+/**************************************************************************/
+static void traceStart(uint8_t lcd_colums)
+{
+  SIMreset();
+  SIMbusInit(&bus);
+  SIMattach(&bus, &sim, SIM_PCF8574, PCF8574_ADDR_A21_A11_A01);
+
+  colums      = lcd_colums;
+  traceLength = 0;
+}
+
+/**************************************************************************/
+/*
+    templateMatches()
+
+    Runs the same calls through C driver & LCD<> template, compares i2c
+    bytes & transactions
+*/
+/**************************************************************************/
+template <uint8_t Cols, uint8_t Rows, class Mapping>
+static bool templateMatches(void)
+{
+  const uint8_t     pins[8] = {Mapping::pin(0), Mapping::pin(1), Mapping::pin(2), Mapping::pin(3), Mapping::pin(4), Mapping::pin(5), Mapping::pin(6), Mapping::pin(7)};
+  static uint8_t    expected[TRACE_SIZE];
+  uint16_t          length  = 0;
+  uint32_t          calls   = 0;
+  LCD<Cols, Rows, LCD_5x8DOTS, Mapping> panel;
+
+  traceStart(Cols);
+  LCDinitBus(&lcd, &traceBus, &bus, PCF8574_ADDR_A21_A11_A01, pins);
+  LCDbegin(&lcd, Cols, Rows);
+  LCDprint(&lcd, "Hello");
+  LCDsetCursor(&lcd, 3, 1);
+  LCDprint(&lcd, "world");
+  LCDsetCursor(&lcd, 8, 1);                          //address counter is there
+  LCDwrite(&lcd, '!');
+  LCDsetCursor(&lcd, 0, Rows - 1);
+  LCDprint(&lcd, "last row");
+  LCDsetCursor(&lcd, 99, 99);                        //clamped
+  LCDwrite(&lcd, '#');
+  LCDclear(&lcd);
+  LCDsetCursor(&lcd, 1, 0);
+  LCDprint(&lcd, "end");
+
+  memcpy(expected, trace, traceLength);
+  length = traceLength;
+  calls  = bus.transactions;
+
+  traceStart(Cols);
+  panel.initBus(&traceBus, &bus);
+  panel.begin();
+  panel.print("Hello");
+  panel.setCursor(3, 1);
+  panel.print("world");
+  panel.template setCursor<8, 1>();
+  panel.write('!');
+  panel.setCursor(0, Rows - 1);
+  panel.print("last row");
+  panel.setCursor(99, 99);
+  panel.write('#');
+  panel.clear();
+  panel.template setCursor<1, 0>();
+  panel.print("end");
+
+  if ((traceLength == length) && (bus.transactions == calls) && (memcmp(trace, expected, length) == 0)) return true;
+
+  printf("  template: %u bytes in %u transactions, wanted %u bytes in %u\n", traceLength, (unsigned)bus.transactions, length, (unsigned)calls);
+  return false;
+}
+
+/**************************************************************************/
+/*
+    testTemplate()
+
+    LCD<> template sends the same bytes as C driver with standard &
+    remapped backpack, other backends go through LCDsend()
+*/
+/**************************************************************************/
+static void testTemplate(void)
+{
+  typedef LCDmapping<6, 5, 4, 7, 0, 1, 2, 3> remapped;
+
+  LCD<16, 2> panel;
+
+  CHECK((templateMatches<16, 2, LCDstandardMapping>()));
+  CHECK_ROW(0, " end");
+  CHECK(sim.violations == 0);
+
+  CHECK((templateMatches<20, 4, remapped>()));       //simulator is wired as standard backpack, bytes only
+
+  /* native controller */
+  SIMreset();
+  SIMbusInit(&bus);
+  SIMattach(&bus, &sim, SIM_ST7032, LCD_NATIVE_ADDR);
+
+  colums = 16;
+
+  panel.initBus(&SIMbusBackend, &bus, LCD_NATIVE_ADDR);
+  LCDbackend(&panel.context, &LCDbackendST7032);
+  CHECK(panel.begin() == true);
+
+  panel.print("tpl");
+  panel.template setCursor<2, 1>();
+  panel.print("native");
+
+  CHECK_ROW(0, "tpl");
+  CHECK_ROW(1, "  native");
+  CHECK(sim.violations == 0);
+}
+
+
+/**************************************************************************/
+/*
+    asyncWrite()
+
+    Simulated DMA write for scheduler test, transfer ends inside the call
+    like a fast interrupt, or later in asyncComplete() if asyncDeferred
+
+    NOTE:
+    - asyncHook is called once on the next transfer, while scheduler
+      chunk is on the bus
+*/
+/**************************************************************************/
+static i2c_scheduler  scheduler;
+static bool           asyncDeferred  = false;
+static uint32_t       asyncBusy      = 0;            //next writes answered with LCD_BUS_BUSY
+static void         (*asyncHook)(void) = NULL;
+static uint8_t        asyncAddress   = 0;
+static const uint8_t *asyncData      = NULL;
+static uint16_t       asyncLength    = 0;
+static uint8_t        asyncLog[ASYNC_LOG_SIZE];      //address of every started transfer
+static uint16_t       asyncLogLength[ASYNC_LOG_SIZE];
+static uint8_t        asyncCount     = 0;
+
+static void asyncComplete(void)
+{
+  if (SIMwrite(&bus, asyncAddress, asyncData, asyncLength) == LCD_BUS_OK) I2CschedulerTxComplete(&scheduler, &bus);
+  else                                                                   I2CschedulerError(&scheduler, &bus);
+}
+
+static lcd_bus_status asyncWrite(void *handle, uint8_t address, const uint8_t *data, uint16_t length)
+{
+  void (*hook)(void) = asyncHook;
+
+  (void)handle;
+
+  if (asyncBusy > 0)
+  {
+    asyncBusy--;
+    return LCD_BUS_BUSY;
+  }
+
+  if (asyncCount < ASYNC_LOG_SIZE)
+  {
+    asyncLog[asyncCount]       = address;
+    asyncLogLength[asyncCount] = length;
+    asyncCount++;
+  }
+
+  asyncAddress = address;
+  asyncData    = data;
+  asyncLength  = length;
+
+  asyncHook = NULL;
+  if (hook != NULL) hook();
+
+  if (asyncDeferred == false) asyncComplete();
+
+  return LCD_BUS_OK;
+}
+
+static const lcd_bus asyncBus     = {SIMwrite, SIMread, asyncWrite, SIMdelay, SIMtimestamp, SIMtimeElapsed, SIMuptime};
+static const lcd_bus schedulerBus = {I2CschedulerLCDwrite, I2CschedulerLCDread, I2CschedulerLCDwriteAsync, SIMdelay, SIMtimestamp, SIMtimeElapsed, SIMuptime}; //I2CschedulerLCDbus on virtual time
+
+/**************************************************************************/
+/*
+    sensorDone()
+
+    Callback of sensor clients, counts finished requests
+*/
+/**************************************************************************/
+static i2c_client     lcdClient;
+static i2c_client     sensorClient;                  //priority 0, address 0x48
+static i2c_client     clientA;                       //priority 1, address 0x49
+static i2c_client     clientB;                       //priority 1, address 0x4A
+static sim_lcd        sensors[3];                    //i2c chips of sensor clients, zeros keep their E low
+static uint8_t        sensorData[64];
+static uint8_t        sensorCalls  = 0;
+static lcd_bus_status sensorStatus = LCD_BUS_OK;
+
+static void sensorDone(i2c_client *client, lcd_bus_status status)
+{
+  (void)client;
+
+  sensorCalls++;
+  sensorStatus = status;
+}
+
+static void sensorsSubmit(void)
+{
+  I2CschedulerWrite(&sensorClient, 0x48, sensorData, 2);
+  I2CschedulerWrite(&clientA,      0x49, sensorData, 64);
+  I2CschedulerWrite(&clientB,      0x4A, sensorData, 64);
+}
+
+/**************************************************************************/
+/*
+    testScheduler()
+
+    Display & sensors share async bus through I2C_Scheduler, chunks,
+    priorities, round robin, utilization, busy & NACK
+*/
+/**************************************************************************/
+static void testScheduler(void)
+{
+  const uint8_t order[] = {PCF8574_ADDR_A21_A11_A01, 0x48, 0x49, 0x4A, 0x49, 0x4A, PCF8574_ADDR_A21_A11_A01};
+  uint32_t      begin   = 0;
+  uint32_t      busy    = 0;
+  uint16_t      load    = 0;
+
+  SIMreset();
+  SIMbusInit(&bus);
+  SIMattach(&bus, &sim, SIM_PCF8574, PCF8574_ADDR_A21_A11_A01);
+
+  for (uint8_t i = 0; i < 3; i++) SIMattach(&bus, &sensors[i], SIM_PCF8574, 0x48 + i);
+
+  colums        = 16;
+  asyncDeferred = false;
+  asyncBusy     = 0;
+  asyncHook     = NULL;
+  sensorCalls   = 0;
+
+  I2CschedulerInit(&scheduler, &asyncBus, &bus);
+  CHECK(I2CschedulerAddClient(&scheduler, &sensorClient, 0, sensorDone, NULL)          == true);
+  CHECK(I2CschedulerAddClient(&scheduler, &lcdClient,    3, I2CschedulerLCDcallback, &lcd) == true);
+  CHECK(I2CschedulerAddClient(&scheduler, &clientA,      1, sensorDone, NULL)          == true);
+  CHECK(I2CschedulerAddClient(&scheduler, &clientB,      1, sensorDone, NULL)          == true);
+
+  LCDinitBus(&lcd, &schedulerBus, &lcdClient, PCF8574_ADDR_A21_A11_A01);
+  CHECK(LCDbegin(&lcd, 16, 2) == true);
+
+  /* 64 bytes of text in 32 byte chunks, sensors submitted during the first one get the bus before the second */
+  asyncCount = 0;
+  asyncHook  = sensorsSubmit;
+  LCDprint(&lcd, "scheduled i2c!!!");
+
+  CHECK(asyncCount == sizeof(order));
+  CHECK(memcmp(asyncLog, order, sizeof(order)) == 0);
+
+  for (uint8_t i = 0; i < asyncCount; i++) CHECK(asyncLogLength[i] <= I2C_SCHEDULER_CHUNK);
+
+  CHECK(asyncLogLength[0]     == I2C_SCHEDULER_CHUNK);
+  CHECK(sensorCalls           == 3);
+  CHECK(sensorStatus          == LCD_BUS_OK);
+  CHECK(clientA.bytes         == 64);
+  CHECK(clientA.transactions  == 2);
+  CHECK_ROW(0, "scheduled i2c!!!");
+
+  /* refused chunk keeps client turn */
+  asyncDeferred = true;
+  asyncCount    = 0;
+  CHECK(I2CschedulerWrite(&clientA, 0x49, sensorData, 64) == LCD_BUS_OK);
+  CHECK(I2CschedulerWrite(&clientB, 0x4A, sensorData, 64) == LCD_BUS_OK);
+  CHECK(I2CschedulerWrite(&clientA, 0x49, sensorData, 64) == LCD_BUS_BUSY); //previous request is not done
+
+  asyncBusy = 1;
+  asyncComplete();                                   //A done, B refused by bus
+  CHECK(asyncCount       == 1);
+  CHECK(scheduler.active == NULL);
+
+  I2CschedulerService(&scheduler);
+  CHECK(asyncCount       == 2);
+  CHECK(asyncLog[1]      == 0x4A);
+
+  while (scheduler.active != NULL) asyncComplete();
+
+  CHECK(asyncCount       == 4);
+  CHECK(asyncLog[2]      == 0x49);
+  CHECK(clientA.pending  == false);
+  CHECK(clientB.pending  == false);
+
+  /* NACK drops request of the client only */
+  sensorCalls         = 0;
+  sensors[1].present  = false;
+  CHECK(I2CschedulerWrite(&clientA, 0x49, sensorData, 64) == LCD_BUS_OK);
+  asyncComplete();
+  CHECK(sensorCalls      == 1);
+  CHECK(sensorStatus     == LCD_BUS_ERROR);
+  CHECK(clientA.status   == LCD_BUS_ERROR);
+  CHECK(clientA.pending  == false);
+  CHECK(scheduler.active == NULL);
+  sensors[1].present  = true;
+
+  /* utilization */
+  I2CschedulerUtilization(&scheduler);
+  begin = SIMtimestamp();
+  CHECK(I2CschedulerWrite(&clientB, 0x4A, sensorData, I2C_SCHEDULER_CHUNK) == LCD_BUS_OK);
+  asyncComplete();
+  busy = SIMtimestamp() - begin;
+  SIMdelay(busy);
+  load = I2CschedulerUtilization(&scheduler);
+  CHECK((load >= 490) && (load <= 510));             //busy half of the window
+
+  SIMdelay(1000);
+  CHECK(I2CschedulerUtilization(&scheduler) == 0);
+
+  /* display keeps working after sensor error */
+  asyncDeferred = false;
+  LCDsetCursor(&lcd, 0, 1);
+  LCDprint(&lcd, "after");
+  CHECK_ROW(1, "after");
+  CHECK(LCDconnected(&lcd) == true);
+  CHECK(sim.violations     == 0);
+}
+
+
+typedef struct
+{
+  const char *name;
+  void      (*run)(void);
+}
+test_case;
+
+static const test_case tests[] =
+{
+  {"init",        testInit},
+  {"print",       testPrint},
+  {"cursor",      testCursor},
+  {"framebuffer", testFrameBuffer},
+  {"budget",      testBudget},
+  {"cgram",       testCgram},
+  {"cgram5x10",   testCgram5x10},
+  {"marquee",     testMarquee},
+  {"autoscroll",  testAutoscroll},
+  {"link",        testLink},
+  {"busy",        testBusy},
+  {"timing",      testTiming},
+  {"backends",    testBackends},
+  {"template",    testTemplate},
+  {"scheduler",   testScheduler}
+};
+
+int main(int argc, char **argv)
+{
+  bool found = false;
+
+  for (uint8_t i = 0; i < (sizeof(tests) / sizeof(tests[0])); i++)
+  {
+    if ((argc > 1) && (strcmp(argv[1], tests[i].name) != 0)) continue;
+
+    uint32_t before = failures;
+
+    found = true;
+    tests[i].run();
+
+    printf("%-12s %s\n", tests[i].name, (failures == before) ? "ok" : "FAILED");
+  }
+
+  if (found == false)
+  {
+    printf("unknown test %s\n", argv[1]);
+    return 2;
+  }
+
+  return (failures == 0) ? 0 : 1;
+}